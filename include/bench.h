@@ -0,0 +1,51 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Cycle benchmark markers.
+//
+// In the clkr_bench build, BENCH_BEGIN and BENCH_END write a section id to
+// the GPIOR0 and GPIOR1 general purpose I/O registers (a single OUT
+// instruction each), which the simavr benchmark in tools/simavr watches to
+// time each section. Everywhere else they compile to nothing.
+//
+// The markers are volatile register writes, so the compiler keeps them in
+// order with the section's own I/O accesses, but it is still free to hoist
+// plain arithmetic across them. Treat the per-section numbers as close
+// estimates and the per-ISR numbers as exact.
+
+#pragma once
+
+namespace clkr {
+enum BenchSection {
+  BENCH_TAP_BUTTON,
+  BENCH_CLOCK_GRIDS,
+  BENCH_CLOCK_OUT,
+  BENCH_NEXT_EDGE,
+  BENCH_LEDS,
+  BENCH_SCAN_POTS,
+  BENCH_SYNC,
+  BENCH_LAST
+};
+}
+
+#if defined(CLKR_BENCH) && defined(__AVR__)
+#define BENCH_BEGIN(section) GPIOR0 = (section)
+#define BENCH_END(section) GPIOR1 = (section)
+#else
+#define BENCH_BEGIN(section)
+#define BENCH_END(section)
+#endif
@@ -1,165 +1,290 @@
-// Copyright 2011 Emilie Gillet, 2023 Katherine Whitlock
-//
-// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
-//         Katherine Whitlock (kate@skylinesynths.nyc)
-//
-// This program is free software: you can redistribute it and/or modify
-// it under the terms of the GNU General Public License as published by
-// the Free Software Foundation, either version 3 of the License, or
-// (at your option) any later version.
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-// You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
-//
-// -----------------------------------------------------------------------------
-//
-// Global clock. This works as a 31-bit phase increment counter.
-
-#pragma once
-#include "avrlib/base.h"
-
-namespace clkr {
-
-// The resolution of the clock
-// output in FAST mode
-enum ClockResolution {
-  CLOCK_RESOLUTION_4_PPQN,
-  CLOCK_RESOLUTION_8_PPQN,
-  CLOCK_RESOLUTION_24_PPQN,
-  CLOCK_RESOLUTION_LAST
-};
-
-// EEPROM-stored settings
-struct Options {
-  ClockResolution clock_resolution;
-  bool tap_tempo;
-  bool locked;
-  bool legacy_mode;
-
-  // Pack the settings to be stored in EEPROM
-  uint8_t pack() const {
-    uint8_t byte = clock_resolution;
-    if (tap_tempo) {
-      byte |= 0x08;
-    }
-    if (locked) {
-      byte |= 0x10;
-    }
-    if (legacy_mode) {
-      byte |= 0x20;
-    }
-    return byte;
-  }
-
-  // Unpack the EEPROM options into the current settings
-  void unpack(uint8_t byte) {
-    tap_tempo = byte & 0x08;
-    locked = byte & 0x10;
-    legacy_mode = byte & 0x20;
-    clock_resolution = static_cast<ClockResolution>(byte & 0x7);
-    if (clock_resolution >= CLOCK_RESOLUTION_24_PPQN) {
-      clock_resolution = CLOCK_RESOLUTION_24_PPQN;
-    }
-  }
-};
-
-const uint8_t kPulsesPerBeat = 24; // 24 pulses per quarter note
-
-class Clock {
-public:
-  Clock() {}
-  ~Clock() {}
-
-  static inline void Init() {
-    Update(120, CLOCK_RESOLUTION_24_PPQN);
-    options_.locked = false;
-    LoadSettings();
-  }
-
-  static void Update(uint16_t bpm, ClockResolution resolution);
-
-  static inline void Reset() { phase_ = 0; }
-
-  static inline void Tick() { phase_ += phase_increment_; }
-  static inline void Wrap(int8_t amount) {
-    LongWord *w = (LongWord *)(&phase_);
-    if (amount == 0) {
-      w->bytes[3] &= 0x7f;
-      falling_edge_ = 0x40;
-    } else {
-      if (w->bytes[3] >= 128 + amount) {
-        w->bytes[3] = 0;
-      }
-      falling_edge_ = (128 + amount) >> 1;
-    }
-  }
-
-  static inline void TickClock(uint8_t num_pulses) {
-    beat_ = pulse_ == 0;
-    first_half_ = pulse_ < (kPulsesPerBeat / 2);
-    pulse_ += num_pulses;
-
-    // Wrap into ppqn steps.
-    while (pulse_ >= kPulsesPerBeat) {
-      pulse_ -= kPulsesPerBeat;
-    }
-  }
-
-  static inline bool raising_edge() { return phase_ < phase_increment_; }
-  static inline bool past_falling_edge() {
-    LongWord w;
-    w.value = phase_;
-    return w.bytes[3] >= falling_edge_;
-  }
-  static inline bool new_pulse() {
-    if (pulse_ != last_pulse_) {
-      last_pulse_ = pulse_;
-      return true;
-    }
-    return false;
-  }
-  static inline void Lock() { options_.locked = true; }
-  static inline void Unlock() { options_.locked = false; }
-  static inline bool locked() { return options_.locked; }
-  static inline uint16_t bpm() { return bpm_; }
-
-  // Options stuff
-  static void SaveSettings();
-  static inline bool legacy_mode() { return options_.legacy_mode; }
-  static void set_legacy_mode(bool value) { options_.legacy_mode = value; }
-  static inline bool tap_tempo() { return options_.tap_tempo; }
-  static void set_tap_tempo(bool value) { options_.tap_tempo = value; }
-  static inline ClockResolution clock_resolution() {
-    return options_.clock_resolution;
-  }
-  static void set_clock_resolution(uint8_t value) {
-    if (value >= CLOCK_RESOLUTION_24_PPQN) {
-      value = CLOCK_RESOLUTION_24_PPQN;
-    }
-    options_.clock_resolution = static_cast<ClockResolution>(value);
-  }
-  static bool on_beat() { return beat_; }
-  static bool on_first_half() { return first_half_; }
-
-private:
-  static void LoadSettings();
-  static Options options_;
-  static bool beat_;
-  static bool first_half_;
-  static uint8_t pulse_;
-  static uint8_t last_pulse_;
-
-  static uint16_t bpm_;
-  static uint32_t phase_;
-  static uint32_t phase_increment_;
-  static uint8_t falling_edge_;
-
-  DISALLOW_COPY_AND_ASSIGN(Clock);
-};
-
-extern Clock clock;
-
+// Copyright 2011 Emilie Gillet, 2023 Katherine Whitlock
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//         Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Global clock. This works as a 31-bit phase increment counter.
+
+#pragma once
+#include "double_buffer.h"
+#include "hal.h"
+
+namespace clkr {
+
+struct Settings;
+
+// The resolution of the clock
+// output in FAST mode
+enum ClockResolution {
+  CLOCK_RESOLUTION_4_PPQN,
+  CLOCK_RESOLUTION_8_PPQN,
+  CLOCK_RESOLUTION_24_PPQN,
+  CLOCK_RESOLUTION_48_PPQN,
+  CLOCK_RESOLUTION_96_PPQN,
+  CLOCK_RESOLUTION_LAST
+};
+
+// How the legacy mode period follows the rate pot and CV, see LegacyPeriod
+enum LegacyCurve {
+  LEGACY_CURVE_LINEAR,
+  LEGACY_CURVE_LOG,
+  LEGACY_CURVE_EXP,
+  LEGACY_CURVE_LAST
+};
+
+// Where the output picks up again when a pause ends, see Pause
+enum RestartMode {
+  RESTART_PHASE_RESET, // from the top of the beat, right away
+  RESTART_IMMEDIATE,   // wherever the clock has got to
+  RESTART_PULSE,       // on the next rising edge
+  RESTART_BEAT,        // on the next rising edge that starts a beat
+  RESTART_LAST
+};
+
+// EEPROM-stored settings
+struct Options {
+  ClockResolution clock_resolution;
+  bool tap_tempo;
+  bool locked;
+  bool legacy_mode;
+  LegacyCurve legacy_curve;
+  // Stored in a byte of its own, see Settings
+  RestartMode restart_mode;
+
+  // Pack the settings to be stored in EEPROM
+  uint8_t pack() const {
+    uint8_t byte = clock_resolution;
+    if (tap_tempo) {
+      byte |= 0x08;
+    }
+    if (locked) {
+      byte |= 0x10;
+    }
+    if (legacy_mode) {
+      byte |= 0x20;
+    }
+    byte |= (legacy_curve + 1) << 6;
+    return byte;
+  }
+
+  // Unpack the EEPROM options into the current settings
+  void unpack(uint8_t byte) {
+    tap_tempo = byte & 0x08;
+    locked = byte & 0x10;
+    legacy_mode = byte & 0x20;
+    clock_resolution = static_cast<ClockResolution>(byte & 0x7);
+    if (clock_resolution >= CLOCK_RESOLUTION_LAST) {
+      clock_resolution = CLOCK_RESOLUTION_24_PPQN;
+    }
+
+    // The curve is stored plus one. Older firmware left these bits clear
+    // and used the tap tempo setting to pick lin or log.
+    uint8_t curve = byte >> 6;
+    if (!curve) {
+      legacy_curve = tap_tempo ? LEGACY_CURVE_LOG : LEGACY_CURVE_LINEAR;
+    } else {
+      legacy_curve = static_cast<LegacyCurve>(curve - 1);
+    }
+  }
+};
+
+// The beat is counted in 96ths, the finest resolution, and every resolution
+// steps through it a whole number of them at a time.
+const uint8_t kPulsesPerBeat = 96;
+
+// Pulses per quarter note of each resolution
+constexpr uint8_t kResolutionPpqn[CLOCK_RESOLUTION_LAST] = {4, 8, 24, 48, 96};
+
+constexpr uint8_t ResolutionPpqn(ClockResolution resolution) {
+  return kResolutionPpqn[resolution];
+}
+
+// Steps of kPulsesPerBeat in one pulse of a resolution
+constexpr uint8_t PulseLength(ClockResolution resolution) {
+  return kPulsesPerBeat / kResolutionPpqn[resolution];
+}
+
+// Fractional bits of ClockRate::edge_unit. Enough to keep the slowest half
+// beat (96 units at 20 BPM) within 32 bits.
+const uint8_t kEdgeFractionalBits = 6;
+
+// Everything the interrupts need to know about the tempo, published by
+// Clock::Update() in one go
+struct ClockRate {
+  // Per control rate tick, for the phase accumulator
+  uint32_t phase_increment;
+  // Length of half a kPulsesPerBeat pulse in CPU cycles, 26.6 fixed point
+  uint32_t edge_unit;
+};
+
+// Rate at which Clock::Tick() is called, in Hz
+const uint16_t kControlRate = 8000;
+
+// Tempi are stored in 1/16 BPM steps, 12.4 fixed point
+const uint8_t kTempoFractionalBits = 4;
+
+constexpr uint16_t BpmToTempo(uint16_t bpm) {
+  return bpm << kTempoFractionalBits;
+}
+
+// Phase increment per control tick for a tempo, at ppqn pulses per beat.
+// The phase wraps at 2^31, so the increment is
+//   tempo / 16 * ppqn / 60 / kControlRate * 2^31
+// which is folded into one 16.16 scale at compile time. The multiply is
+// split into integral and fractional halves to stay within 32 bits.
+template <uint8_t ppqn> struct TempoScale {
+  static constexpr uint32_t kScale =
+      ((static_cast<uint64_t>(ppqn) << (31 + 16 - kTempoFractionalBits)) +
+       60UL * kControlRate / 2) /
+      (60UL * kControlRate);
+
+  static constexpr uint32_t PhaseIncrement(uint16_t tempo) {
+    return tempo * (kScale >> 16) + ((tempo * (kScale & 0xffff)) >> 16);
+  }
+};
+
+class Clock {
+public:
+  Clock() {}
+  ~Clock() {}
+
+  static inline void Init() {
+    Update(BpmToTempo(120), CLOCK_RESOLUTION_24_PPQN);
+    options_.locked = false;
+    LoadSettings();
+  }
+
+  // Set the tempo, in 1/16 BPM steps
+  static void Update(uint16_t tempo, ClockResolution resolution);
+
+  // Start a pulse on the next Tick(), with the phase just short of its wrap
+  static inline void Reset() {
+    phase_ = 0x7fffffff;
+    edge_fraction_ = 0;
+  }
+
+  // Reset, and go back to the top of the beat. Whatever the last pulse was,
+  // new_pulse() sees the next one.
+  static inline void Restart() {
+    Reset();
+    pulse_ = 0;
+    last_pulse_ = kPulsesPerBeat;
+  }
+
+  static inline void Tick() { phase_ += rate_.Read().phase_increment; }
+  static inline void Wrap(int8_t amount) {
+    LongWord *w = (LongWord *)(&phase_);
+    if (amount == 0) {
+      w->bytes[3] &= 0x7f;
+      falling_edge_ = 0x40;
+    } else {
+      if (w->bytes[3] >= 128 + amount) {
+        w->bytes[3] = 0;
+      }
+      falling_edge_ = (128 + amount) >> 1;
+    }
+  }
+
+  static inline void TickClock(uint8_t num_pulses) {
+    beat_ = pulse_ == 0;
+    first_half_ = pulse_ < (kPulsesPerBeat / 2);
+    pulse_ += num_pulses;
+
+    // Wrap into ppqn steps.
+    while (pulse_ >= kPulsesPerBeat) {
+      pulse_ -= kPulsesPerBeat;
+    }
+  }
+
+  // Cycles until the next scheduled edge, num_half_pulses halves of a
+  // kPulsesPerBeat pulse away from the previous one. The fractional cycles
+  // carry over from edge to edge so the edge stream never drifts from the
+  // tempo.
+  static inline uint32_t NextEdgeInterval(uint8_t num_half_pulses) {
+    uint32_t interval =
+        rate_.Read().edge_unit * num_half_pulses + edge_fraction_;
+    edge_fraction_ = interval & ((1 << kEdgeFractionalBits) - 1);
+    return interval >> kEdgeFractionalBits;
+  }
+
+  static inline bool raising_edge() {
+    return phase_ < rate_.Read().phase_increment;
+  }
+  static inline bool past_falling_edge() {
+    LongWord w;
+    w.value = phase_;
+    return w.bytes[3] >= falling_edge_;
+  }
+  static inline bool new_pulse() {
+    if (pulse_ != last_pulse_) {
+      last_pulse_ = pulse_;
+      return true;
+    }
+    return false;
+  }
+  static inline void Lock() { options_.locked = true; }
+  static inline void Unlock() { options_.locked = false; }
+  static inline bool locked() { return options_.locked; }
+  static inline uint16_t tempo() { return tempo_; }
+
+  // Options stuff. Saving only queues a journal record, see SettingsJournal.
+  static void SaveSettings();
+  static Settings settings();
+  static inline bool legacy_mode() { return options_.legacy_mode; }
+  static void set_legacy_mode(bool value) { options_.legacy_mode = value; }
+  static inline LegacyCurve legacy_curve() { return options_.legacy_curve; }
+  static void set_legacy_curve(LegacyCurve value) {
+    options_.legacy_curve = value;
+  }
+  static inline RestartMode restart_mode() { return options_.restart_mode; }
+  static void set_restart_mode(RestartMode value) {
+    options_.restart_mode = value;
+  }
+  static inline bool tap_tempo() { return options_.tap_tempo; }
+  static void set_tap_tempo(bool value) { options_.tap_tempo = value; }
+  static inline ClockResolution clock_resolution() {
+    return options_.clock_resolution;
+  }
+  static void set_clock_resolution(uint8_t value) {
+    if (value >= CLOCK_RESOLUTION_LAST) {
+      value = CLOCK_RESOLUTION_LAST - 1;
+    }
+    options_.clock_resolution = static_cast<ClockResolution>(value);
+  }
+  static bool on_beat() { return beat_; }
+  static bool on_first_half() { return first_half_; }
+
+private:
+  static void LoadSettings();
+  static Options options_;
+  static bool beat_;
+  static bool first_half_;
+  static uint8_t pulse_;
+  static uint8_t last_pulse_;
+
+  static uint16_t tempo_;
+  static uint32_t phase_;
+  static DoubleBuffer<ClockRate> rate_;
+  static uint8_t falling_edge_;
+
+  static uint8_t edge_fraction_;
+
+  DISALLOW_COPY_AND_ASSIGN(Clock);
+};
+
+extern Clock clock;
+
 } // namespace clkr
\ No newline at end of file
@@ -0,0 +1,60 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Double buffer for values the main loop hands to the interrupts.
+
+#pragma once
+#include <stdint.h>
+
+#include "hal.h"
+
+namespace clkr {
+
+/**
+ * @brief A value written by the main loop and read by interrupts, without
+ *        ever being seen half written
+ *
+ * The writer fills in the copy the readers aren't looking at, then flips
+ * a single byte index over to it. Readers must not be preempted by the
+ * writer, which holds for interrupts reading what the main loop writes, so
+ * the copy they are handed stays whole for as long as they run.
+ *
+ * @tparam T The value type, any size
+ */
+template <typename T> class DoubleBuffer {
+public:
+  DoubleBuffer() {}
+  ~DoubleBuffer() {}
+
+  // From the writer, publish a complete new value
+  inline void Write(const T &value) {
+    uint8_t back = !front_;
+    buffers_[back] = value;
+    hal::MemoryBarrier();
+    front_ = back;
+  }
+
+  // From a reader
+  inline const T &Read() const { return buffers_[front_]; }
+
+private:
+  T buffers_[2] = {};
+  volatile uint8_t front_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(DoubleBuffer);
+};
+
+} // namespace clkr
@@ -0,0 +1,89 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Output edge scheduler.
+//
+// Places events on Timer1 compare B, to the CPU cycle, at any distance up to
+// 32 bits of timer counts (3.5 minutes). OCR1B only holds 16 bits, so a long
+// interval is walked in steps of at most one full timer wrap (3.3ms), and
+// TIMER1_COMPB_vect only fires once per wrap on the way and once more on the
+// target itself.
+
+#pragma once
+#include "hal.h"
+
+namespace clkr {
+
+class EdgeScheduler {
+public:
+  EdgeScheduler() {}
+  ~EdgeScheduler() {}
+
+  // Intervals must be at least this long, so the compare point is always
+  // well ahead of the counter by the time it is written (51us).
+  static const uint16_t kMinimumInterval = 1024;
+
+  // Schedule the first event interval counts from now
+  static void Start(uint32_t interval);
+  static void Stop();
+  static inline bool running() { return running_; }
+
+  // Timer1 count of the next compare match
+  static inline uint16_t compare() { return compare_; }
+
+  // To be called from TIMER1_COMPB_vect. Returns true when the compare
+  // match is the scheduled event, or false for a wrap on the way to it.
+  static inline bool Expired() {
+    if (remaining_ == 0) {
+      return true;
+    }
+    Step();
+    return false;
+  }
+
+  // Schedule the next event interval counts after the one that just expired
+  static inline void Next(uint32_t interval) {
+    remaining_ = interval;
+    Step();
+  }
+
+private:
+  static inline void Step() {
+    if (remaining_ > 0xffff) {
+      // Stay a full wrap away from the target, or split the distance so
+      // neither step lands too close to the counter.
+      uint32_t step = 0x10000;
+      if (remaining_ < 0x10000 + kMinimumInterval) {
+        step = remaining_ >> 1;
+      }
+      remaining_ -= step;
+      compare_ += static_cast<uint16_t>(step);
+    } else {
+      compare_ += static_cast<uint16_t>(remaining_);
+      remaining_ = 0;
+    }
+    hal::EdgeTimer::set_compare(compare_);
+  }
+
+  static uint16_t compare_;
+  static uint32_t remaining_;
+  static bool running_;
+
+  DISALLOW_COPY_AND_ASSIGN(EdgeScheduler);
+};
+
+} // namespace clkr
@@ -0,0 +1,59 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Background EEPROM writes, paced by the EEPROM ready interrupt.
+
+#pragma once
+#include <stdint.h>
+
+#include "hal.h"
+
+namespace clkr {
+
+/**
+ * @brief Queue of pending EEPROM writes, written out one byte per EE_READY
+ *        interrupt
+ *
+ * A byte write takes about 3.4ms, so writing in place stalls whoever does
+ * it. Write() only queues the byte and returns. Queuing an address that is
+ * still pending replaces its value, so a burst of saves ends up writing the
+ * last one only, and bytes that already hold their value are skipped rather
+ * than worn. Writes happen in the order their addresses were first queued.
+ */
+class EepromWriter {
+public:
+  static const uint8_t kQueueSize = 16;
+
+  // From the main loop. Returns false, dropping the byte, if the queue is
+  // full of other addresses.
+  static bool Write(uint16_t address, uint8_t value);
+
+  // Nothing queued or being written
+  static inline bool idle() { return !count_ && !hal::Eeprom::busy(); }
+
+  // From EE_READY, start the next write that changes something
+  static void Ready();
+
+private:
+  static uint16_t addresses_[kQueueSize];
+  static uint8_t values_[kQueueSize];
+  static volatile uint8_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(EepromWriter);
+};
+
+} // namespace clkr
@@ -0,0 +1,98 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Event queue from the interrupts to the main loop.
+
+#pragma once
+#include <stdint.h>
+
+#include "hal.h"
+
+namespace clkr {
+
+/**
+ * @brief Lock-free single producer, single consumer ring buffer
+ *
+ * The producer only ever writes head_ and the consumer tail_, each after the
+ * slot it covers, so neither side needs to disable interrupts. Only one
+ * producer may push at a time: an interrupt that can be preempted by another
+ * one pushing to the same queue has to push with interrupts disabled.
+ *
+ * @tparam T The event type
+ * @tparam size The number of slots, a power of two. One is kept free to
+ *              tell a full queue from an empty one.
+ */
+template <typename T, uint8_t size> class EventQueue {
+  static_assert(size && !(size & (size - 1)), "size must be a power of two");
+
+public:
+  EventQueue() {}
+  ~EventQueue() {}
+
+  // From the producer. Drops the event if the queue is full.
+  inline bool Push(const T &event) {
+    uint8_t head = head_;
+    uint8_t next = (head + 1) & (size - 1);
+    if (next == tail_) {
+      ++overflows_;
+      return false;
+    }
+    events_[head] = event;
+    hal::MemoryBarrier();
+    head_ = next;
+    return true;
+  }
+
+  // From the consumer
+  inline bool Pop(T *event) {
+    uint8_t tail = tail_;
+    if (tail == head_) {
+      return false;
+    }
+    hal::MemoryBarrier();
+    *event = events_[tail];
+    hal::MemoryBarrier();
+    tail_ = (tail + 1) & (size - 1);
+    return true;
+  }
+
+  inline bool empty() const { return head_ == tail_; }
+
+  // Events dropped because the queue was full
+  inline uint8_t overflows() const { return overflows_; }
+
+private:
+  T events_[size];
+  volatile uint8_t head_ = 0;
+  volatile uint8_t tail_ = 0;
+  volatile uint8_t overflows_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(EventQueue);
+};
+
+enum EventType {
+  EVENT_BUTTON_PRESSED,
+  EVENT_BUTTON_RELEASED,
+  EVENT_LONG_PRESS,
+};
+
+struct Event {
+  uint8_t type;
+  uint8_t value;
+  uint32_t time; // Timebase::now(), in Timer1 counts
+};
+
+} // namespace clkr
@@ -0,0 +1,132 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Smoothing filters for the analog inputs
+
+#pragma once
+#include "hal.h"
+#include <stdint.h>
+
+namespace clkr {
+
+/**
+ * @brief Moving average over the last 2^shift values
+ *
+ * The window is a power of two, so the average is a shift rather than a
+ * division.
+ *
+ * @tparam shift log2 of the window length
+ */
+template <uint8_t shift> class MovingAverage {
+public:
+  static const uint8_t kLength = 1 << shift;
+
+  MovingAverage() {}
+
+  inline uint16_t push_and_get(uint16_t new_value) {
+    total_ -= history_[index_];
+    total_ += new_value;
+    history_[index_] = new_value;
+    index_ = (index_ + 1) & (kLength - 1);
+    return total_ >> shift;
+  }
+
+  inline uint16_t get() const { return total_ >> shift; }
+
+private:
+  uint16_t history_[kLength] = {0};
+  uint8_t index_ = 0;
+  uint32_t total_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(MovingAverage);
+};
+
+/**
+ * @brief One pole low pass, y += (x - y) / 2^shift
+ *
+ * The state keeps shift extra bits of precision, so the output settles on
+ * the input exactly instead of stalling up to 2^shift short of it.
+ *
+ * @tparam shift log2 of the time constant, in samples
+ */
+template <uint8_t shift> class OnePole {
+public:
+  OnePole() {}
+
+  inline uint16_t push_and_get(uint16_t new_value) {
+    state_ += static_cast<int32_t>(new_value) - get();
+    return get();
+  }
+
+  inline uint16_t get() const { return state_ >> shift; }
+
+private:
+  uint32_t state_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(OnePole);
+};
+
+/**
+ * @brief One pole low pass that follows large moves quickly and smooths small
+ *        ones heavily, followed by a deadband
+ *
+ * While the input is within threshold of the filtered value the time
+ * constant is 2^slow_shift samples, beyond it 2^fast_shift. The output then
+ * only jumps to the filtered value once the two are more than deadband apart,
+ * so noise around a resting pot never reaches the clock.
+ *
+ * @tparam slow_shift log2 of the time constant for small moves
+ * @tparam fast_shift log2 of the time constant for large moves
+ * @tparam threshold difference between input and filter that counts as large
+ * @tparam deadband change in the filtered value needed to move the output
+ */
+template <uint8_t slow_shift, uint8_t fast_shift, uint16_t threshold,
+          uint16_t deadband>
+class AdaptiveFilter {
+  static_assert(fast_shift < slow_shift, "fast_shift must be below slow_shift");
+
+public:
+  AdaptiveFilter() {}
+
+  inline uint16_t push_and_get(uint16_t new_value) {
+    uint16_t filtered = state_ >> slow_shift;
+    int32_t error = static_cast<int32_t>(new_value) - filtered;
+    if (error > threshold || error < -static_cast<int32_t>(threshold)) {
+      // Same as y += e / 2^fast_shift, in the slow filter's fixed point
+      state_ += error * (1L << (slow_shift - fast_shift));
+    } else {
+      state_ += error;
+    }
+    filtered = state_ >> slow_shift;
+
+    int32_t change = static_cast<int32_t>(filtered) - value_;
+    if (change > deadband || change < -static_cast<int32_t>(deadband)) {
+      value_ = filtered;
+    }
+    return value_;
+  }
+
+  inline uint16_t get() const { return value_; }
+
+private:
+  uint32_t state_ = 0;
+  uint16_t value_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(AdaptiveFilter);
+};
+
+} // namespace clkr
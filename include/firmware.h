@@ -0,0 +1,53 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Firmware entry points, shared by main() on the module and by the native
+// simulator, which drives them with a simulated 8 kHz tick.
+
+#pragma once
+#include <stdint.h>
+
+#include "clock.h"
+#include "hal.h"
+
+// Timer1 runs free at the CPU clock (50ns per count),
+// 20MHz / 2500 = 8khz (125us) control rate
+constexpr uint16_t kUpdatePeriod =
+    F_CPU / clkr::hal::kTimer1Prescaler / clkr::kControlRate;
+
+// Grids mode edges are placed to the cycle by the EdgeScheduler, unless
+// built with CLKR_POLLED_EDGES, where they follow the 8khz phase accumulator
+// like the original Grids clock.
+#ifdef CLKR_POLLED_EDGES
+constexpr bool kScheduledEdges = false;
+#else
+constexpr bool kScheduledEdges = true;
+#endif
+
+// With CLKR_SYNC, the Pause CV jack becomes a sync input for an external
+// clock, which the Grids output locks on to (see sync_pll.h).
+#ifdef CLKR_SYNC
+constexpr bool kSyncInput = true;
+static_assert(kScheduledEdges, "sync places edges with the EdgeScheduler");
+#else
+constexpr bool kSyncInput = false;
+#endif
+
+void Init();
+
+// One pass of the main loop, runs whichever tasks are due
+void RunTasks();
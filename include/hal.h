@@ -0,0 +1,32 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Hardware abstraction layer.
+//
+// The clock engine only talks to the hardware through the small set of
+// static classes declared here (timers, GPIO, ADC, PWM and EEPROM). On the
+// module they are thin inline wrappers around the AVR registers and avrlib;
+// in the native build they are backed by a simulated ATmega328P so the
+// engine can be run and inspected on a desktop machine.
+
+#pragma once
+
+#ifdef __AVR__
+#include "hal_avr.h"
+#else
+#include "hal_native.h"
+#endif
@@ -0,0 +1,236 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Hardware abstraction layer, ATmega328P implementation.
+
+#pragma once
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+
+#include "avrlib/base.h"
+#include "avrlib/gpio.h"
+#include "avrlib/op.h"
+#include "avrlib/time.h"
+
+namespace clkr {
+namespace hal {
+
+const uint16_t kEepromSize = E2END + 1;
+const uint8_t kTimer1Prescaler = 1;
+
+inline void EnableInterrupts() { sei(); }
+
+// Idle until the next interrupt, the timers and ADC keep running
+inline void Sleep() {
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+}
+
+// Keeps the compiler from moving memory accesses across it
+inline void MemoryBarrier() { __asm__ __volatile__("" ::: "memory"); }
+
+// Disables interrupts for its lifetime, then restores the previous state
+class InterruptLock {
+public:
+  InterruptLock() : sreg_(SREG) { cli(); }
+  ~InterruptLock() { SREG = sreg_; }
+
+private:
+  uint8_t sreg_;
+};
+
+inline void Delay(uint16_t milliseconds) {
+  avrlib::ConstantDelay(milliseconds);
+}
+
+// PB5/SCK - Clock gate output
+struct ClockOut {
+  typedef avrlib::Gpio<avrlib::PortB, 5> Pin;
+  static inline void Init() { Pin::set_mode(avrlib::DIGITAL_OUTPUT); }
+  static inline void set_value(uint8_t value) { Pin::set_value(value); }
+};
+
+// PB4/MISO - Pause/Tap switch input, no pullup
+struct Button {
+  typedef avrlib::DigitalInput<avrlib::Gpio<avrlib::PortB, 4>> Pin;
+  static inline void Init() {
+    Pin::Init();
+    Pin::DisablePullUpResistor();
+  }
+  static inline uint8_t Read() { return Pin::Read(); }
+};
+
+// PC3/ADC3 - Pause CV input, watched by the pin change interrupt
+struct PauseCv {
+  static inline void Init() {
+    PCICR |= _BV(PCIE1);
+    PCMSK1 |= _BV(PCINT11);
+  }
+
+  // Invert because of the inverting op-amp input
+  // (high CV is low MCU input)
+  static inline bool Read() { return !(PINC & _BV(PINC3)); }
+  static inline bool pending() { return PCIFR & _BV(PCIF1); }
+};
+
+// Analog inputs, converted round-robin in the background. Every Timer0
+// overflow (78kHz, see LedPwm) triggers a conversion once the previous one
+// is done, about 11k a second, and the conversion complete interrupt
+// (ADC_vect) sums 4^kOversamplingBits of them per channel before moving on
+// to the next one. The sum is decimated to 10 + kOversamplingBits bits, 12
+// with the default of 2, and left aligned.
+class Adc {
+public:
+  static const uint8_t kOversamplingBits = 2;
+  static const uint8_t kMaxInputs = 8;
+  // What the lowest of those bits is worth, left aligned
+  static const uint16_t kReadingStep = 1 << (6 - kOversamplingBits);
+
+  // Both the sample count and the 16-bit sum run out past 3
+  static_assert(kOversamplingBits <= 3, "too many samples to sum");
+
+  static void Init(uint8_t num_inputs);
+
+  // Nothing to do, the interrupt keeps the readings fresh
+  static inline void Scan() {}
+
+  // Latest reading, left aligned to 16 bits
+  static inline uint16_t Read16(uint8_t channel) {
+    InterruptLock lock;
+    return readings_[channel];
+  }
+  static inline uint8_t Read8(uint8_t channel) {
+    return Read16(channel) >> 8;
+  }
+
+  // From ADC_vect
+  static inline void Convert() {
+    accumulator_ += ADC;
+    if (++count_ == (1 << (2 * kOversamplingBits))) {
+      // Decimate, then left align
+      readings_[channel_] = (accumulator_ >> kOversamplingBits)
+                            << (6 - kOversamplingBits);
+      accumulator_ = 0;
+      count_ = 0;
+      channel_ = channel_ + 1 < num_inputs_ ? channel_ + 1 : 0;
+      ADMUX = _BV(REFS0) | channel_;
+    }
+    // The trigger only fires again once its flag is cleared
+    TIFR0 = _BV(TOV0);
+  }
+
+private:
+  static uint8_t num_inputs_;
+  static uint8_t channel_;
+  static uint8_t count_;
+  static uint16_t accumulator_;
+  static volatile uint16_t readings_[kMaxInputs];
+};
+
+// Timer0 fast PWM driving the two LEDs.
+// Channel 0 is OC0B (PD5, top LED), channel 1 is OC0A (PD6, bottom LED).
+struct LedPwm {
+  static inline void Init() {
+    DDRD |= _BV(PD6) | _BV(PD5);
+    OCR0A = 0;
+    OCR0B = 0;
+    // Fast PWM mode 3, the outputs are connected by Enable()
+    TCCR0A = _BV(WGM01) | _BV(WGM00);
+    TCCR0B = _BV(CS00);  // No-Prescalar
+  }
+
+  static inline void Enable(uint8_t channel, bool enabled) {
+    uint8_t mask = channel ? _BV(COM0A1) : _BV(COM0B1);
+    if (enabled) {
+      TCCR0A |= mask;
+    } else {
+      TCCR0A &= ~mask;
+    }
+  }
+
+  static inline void Write(uint8_t channel, uint8_t value) {
+    if (channel) {
+      OCR0A = value;
+    } else {
+      OCR0B = value;
+    }
+  }
+};
+
+// Timer1 runs free at the CPU clock. Compare A paces the control rate tick
+// (TIMER1_COMPA_vect), compare B belongs to the EdgeTimer.
+//
+// Its 16-bit registers share a single TEMP byte, so they may only be touched
+// with interrupts disabled.
+struct TickTimer {
+  static inline void Init(uint16_t period) {
+    TCCR1A = 0x00;
+    TCCR1B = _BV(CS10); // Normal mode, no prescaler (kTimer1Prescaler)
+    OCR1A = period;
+    TIMSK1 = _BV(OCIE1A); // Output Compare Match A Interrupt Enable
+  }
+
+  // Move the compare point on to the next tick
+  static inline void Advance(uint16_t period) { OCR1A += period; }
+  static inline uint16_t compare() { return OCR1A; }
+  static inline uint16_t now() { return TCNT1; }
+  static inline bool pending() { return TIFR1 & _BV(OCF1A); }
+};
+
+// Timer1 compare B (TIMER1_COMPB_vect), for events placed to the count
+struct EdgeTimer {
+  static inline void Enable(bool enabled) {
+    if (enabled) {
+      TIFR1 = _BV(OCF1B); // drop any stale match
+      TIMSK1 |= _BV(OCIE1B);
+    } else {
+      TIMSK1 &= ~_BV(OCIE1B);
+    }
+  }
+  static inline uint16_t now() { return TCNT1; }
+  static inline void set_compare(uint16_t count) { OCR1B = count; }
+  static inline bool pending() { return TIFR1 & _BV(OCF1B); }
+};
+
+// Reads wait out any write in progress. Writes only start the erase and
+// write cycle (about 3.4ms), see EepromWriter.
+struct Eeprom {
+  static inline uint8_t Read(uint16_t address) {
+    return eeprom_read_byte(reinterpret_cast<uint8_t *>(address));
+  }
+  static inline bool busy() { return EECR & _BV(EEPE); }
+  static inline void StartWrite(uint16_t address, uint8_t value) {
+    InterruptLock lock; // EEPE has to follow EEMPE within four cycles
+    EEAR = address;
+    EEDR = value;
+    EECR |= _BV(EEMPE);
+    EECR |= _BV(EEPE);
+  }
+  static inline void EnableReadyInterrupt(bool enabled) {
+    if (enabled) {
+      EECR |= _BV(EERIE);
+    } else {
+      EECR &= ~_BV(EERIE);
+    }
+  }
+};
+
+} // namespace hal
+} // namespace clkr
@@ -0,0 +1,245 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Hardware abstraction layer, native (simulated) implementation.
+//
+// Provides the handful of avr-libc/avrlib definitions the engine relies on,
+// and a cycle-counting model of the peripherals CLKr uses. Interrupt vectors
+// become plain functions that the simulator calls when a timer fires.
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 20000000L
+#endif
+
+#define PROGMEM
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t *>(address))
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t *>(address))
+#define pgm_read_dword(address) (*reinterpret_cast<const uint32_t *>(address))
+
+#define ISR_NOBLOCK
+#define ISR(vector, ...) extern "C" void vector(void)
+
+#define DISALLOW_COPY_AND_ASSIGN(TypeName)                                     \
+  TypeName(const TypeName &);                                                  \
+  void operator=(const TypeName &)
+
+enum DigitalValue { LOW = 0, HIGH = 1 };
+
+typedef union {
+  uint16_t value;
+  uint8_t bytes[2];
+} Word;
+
+typedef union {
+  uint32_t value;
+  uint16_t words[2];
+  uint8_t bytes[4];
+} LongWord;
+
+static inline uint8_t U8U8MulShift8(uint8_t a, uint8_t b) {
+  return static_cast<uint16_t>(a) * b >> 8;
+}
+
+extern "C" void TIMER1_COMPA_vect(void);
+extern "C" void TIMER1_COMPB_vect(void);
+extern "C" void PCINT1_vect(void);
+extern "C" void EE_READY_vect(void);
+
+namespace clkr {
+namespace hal {
+
+const uint16_t kEepromSize = 1024;
+const uint32_t kEepromWriteCycles = F_CPU / 1000 * 34 / 10;
+const uint8_t kTimer1Prescaler = 1;
+
+// State of the simulated microcontroller. Time is kept in CPU cycles.
+struct Simulator {
+  uint64_t cycle;
+
+  // Timer1, free running at the CPU clock, and the cycles of its next compare
+  // matches. Compare A is always enabled once the tick timer is set up.
+  bool tick_enabled;
+  bool edge_enabled;
+  uint16_t compare_a;
+  uint16_t compare_b;
+  uint64_t next_tick;
+  uint64_t next_edge;
+
+  uint8_t clock_out;
+  uint8_t button;
+  bool pause_cv;
+  // Left aligned, like the AVR's oversampled readings
+  uint16_t adc[8];
+  bool led_enabled[2];
+  uint8_t led_pwm[2];
+  uint8_t eeprom[kEepromSize];
+
+  // EEPROM ready interrupt, and the cycle the write in progress finishes
+  bool eeprom_ready_enabled;
+  uint64_t eeprom_ready;
+
+  // Called whenever the clock output pin changes level
+  void (*on_clock_out)(uint64_t cycle, uint8_t value);
+
+  // Called after every control rate tick, standing in for the main loop
+  void (*main_loop)();
+};
+
+extern Simulator simulator;
+
+// Reset the simulated hardware to its power-on state (erased EEPROM)
+void SimulatorReset();
+
+// Cycle of the next time Timer1 counts up to the given value
+uint64_t SimulatorNextMatch(uint16_t count);
+
+// Run the timers (and their interrupts) for the given number of cycles
+// without calling back into the main loop.
+void SimulatorAdvance(uint64_t cycles);
+
+// Run the timers for the given number of cycles, calling the main loop
+// after every control rate tick.
+void SimulatorRun(uint64_t cycles);
+
+// Change the level on the Pause CV jack, firing the pin change interrupt
+void SimulatorSetPauseCv(bool high);
+
+// Hold an ADC input at an 8-bit reading, stretched to the 12 bits of the
+// AVR's. Full scale stays (nearly) full scale.
+void SimulatorSetAdc(uint8_t channel, uint8_t value);
+
+inline void EnableInterrupts() {}
+
+// The simulator calls the main loop once per tick instead
+inline void Sleep() {}
+
+inline void MemoryBarrier() { __asm__ __volatile__("" ::: "memory"); }
+
+class InterruptLock {
+public:
+  InterruptLock() {}
+  ~InterruptLock() {}
+};
+
+inline void Delay(uint16_t milliseconds) {
+  SimulatorAdvance(static_cast<uint64_t>(milliseconds) * (F_CPU / 1000));
+}
+
+struct ClockOut {
+  static inline void Init() {}
+  static inline void set_value(uint8_t value) {
+    if (value != simulator.clock_out) {
+      simulator.clock_out = value;
+      if (simulator.on_clock_out) {
+        simulator.on_clock_out(simulator.cycle, value);
+      }
+    }
+  }
+};
+
+struct Button {
+  static inline void Init() {}
+  static inline uint8_t Read() { return simulator.button; }
+};
+
+struct PauseCv {
+  static inline void Init() {}
+  static inline bool Read() { return simulator.pause_cv; }
+  // The simulated pin change interrupt fires as the level changes
+  static inline bool pending() { return false; }
+};
+
+struct Adc {
+  // As the AVR's 12-bit readings, which input logs from a module hold
+  static const uint16_t kReadingStep = 16;
+
+  static inline void Init(uint8_t /* num_inputs */) {}
+  static inline void Scan() {}
+  static inline uint16_t Read16(uint8_t channel) {
+    return simulator.adc[channel];
+  }
+  static inline uint8_t Read8(uint8_t channel) {
+    return simulator.adc[channel] >> 8;
+  }
+};
+
+struct LedPwm {
+  static inline void Init() {
+    simulator.led_enabled[0] = simulator.led_enabled[1] = false;
+    simulator.led_pwm[0] = simulator.led_pwm[1] = 0;
+  }
+  static inline void Enable(uint8_t channel, bool enabled) {
+    simulator.led_enabled[channel] = enabled;
+  }
+  static inline void Write(uint8_t channel, uint8_t value) {
+    simulator.led_pwm[channel] = value;
+  }
+};
+
+struct TickTimer {
+  static inline void Init(uint16_t period) {
+    simulator.tick_enabled = true;
+    simulator.compare_a = now() + period;
+    simulator.next_tick = SimulatorNextMatch(simulator.compare_a);
+  }
+  static inline void Advance(uint16_t period) {
+    simulator.compare_a += period;
+    simulator.next_tick = SimulatorNextMatch(simulator.compare_a);
+  }
+  static inline uint16_t compare() { return simulator.compare_a; }
+  static inline uint16_t now() {
+    return static_cast<uint16_t>(simulator.cycle / kTimer1Prescaler);
+  }
+  static inline bool pending() {
+    return simulator.tick_enabled && simulator.cycle >= simulator.next_tick;
+  }
+};
+
+struct EdgeTimer {
+  static inline void Enable(bool enabled) {
+    simulator.edge_enabled = enabled;
+  }
+  static inline uint16_t now() { return TickTimer::now(); }
+  static inline void set_compare(uint16_t count) {
+    simulator.compare_b = count;
+    simulator.next_edge = SimulatorNextMatch(count);
+  }
+  static inline bool pending() {
+    return simulator.edge_enabled && simulator.cycle >= simulator.next_edge;
+  }
+};
+
+struct Eeprom {
+  static inline uint8_t Read(uint16_t address) {
+    return simulator.eeprom[address % kEepromSize];
+  }
+  static inline bool busy() { return simulator.cycle < simulator.eeprom_ready; }
+  static inline void StartWrite(uint16_t address, uint8_t value) {
+    simulator.eeprom[address % kEepromSize] = value;
+    simulator.eeprom_ready = simulator.cycle + kEepromWriteCycles;
+  }
+  static inline void EnableReadyInterrupt(bool enabled) {
+    simulator.eeprom_ready_enabled = enabled;
+  }
+};
+
+} // namespace hal
+} // namespace clkr
@@ -1,12 +1,12 @@
-#pragma once
-
-namespace clkr {
-enum AdcChannel {
-  ADC_CHANNEL_NONE,
-  ADC_CHANNEL_TEMPO,
-  ADC_CHANNEL_SELECTOR,
-  ADC_CHANNEL_PAUSE_CV,
-  ADC_CHANNEL_TEMPO_CV,
-  ADC_CHANNEL_LAST
-};
+#pragma once
+
+namespace clkr {
+enum AdcChannel {
+  ADC_CHANNEL_NONE,
+  ADC_CHANNEL_TEMPO,
+  ADC_CHANNEL_SELECTOR,
+  ADC_CHANNEL_PAUSE_CV,
+  ADC_CHANNEL_TEMPO_CV,
+  ADC_CHANNEL_LAST
+};
 }
\ No newline at end of file
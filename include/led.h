@@ -1,77 +1,112 @@
-// Copyright 2023 Katherine Whitlock
-//
-// Author: Katherine Whitlock (kate@skylinesynths.nyc)
-//
-// This program is free software: you can redistribute it and/or modify
-// it under the terms of the GNU General Public License as published by
-// the Free Software Foundation, either version 3 of the License, or
-// (at your option) any later version.
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-// You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
-//
-// -----------------------------------------------------------------------------
-//
-// LED helper functions
-
-#pragma once
-#include <stdint.h>
-#include <avr/io.h>
-#include "hardware_config.h"
-
-namespace clkr {
-enum LEDs {
-  LED_CLOCK, // PD5
-  LED_PAUSE  // PD6
-};
-
-enum LedBrightness {
-  BRIGHTNESS_NONE = 0x00,
-  BRIGHTNESS_HALF = 0x7F,
-  BRIGHTNESS_FULL = 0xFF
-};
-
-inline void PWMOff(LEDs led) {
-  switch (led) {
-  case LED_PAUSE:
-    TCCR0A &= ~_BV(COM0A1);
-    break;
-  case LED_CLOCK:
-    TCCR0A &= ~_BV(COM0B1);
-    break;
-  }
-}
-
-inline void PWMOn(LEDs led) {
-  switch (led) {
-  case LED_PAUSE:
-    TCCR0A |= _BV(COM0A1);
-    break;
-  case LED_CLOCK:
-    TCCR0A |= _BV(COM0B1);
-    break;
-  }
-}
-
-inline void LedSetBrightness(LEDs led, uint8_t brightness) {
-  if (brightness <= 0) {
-    PWMOff(led);
-  } else {
-    PWMOn(led);
-    switch (led) {
-    case LED_PAUSE:
-      OCR0A = brightness;
-      break;
-    case LED_CLOCK:
-      OCR0B = brightness;
-      break;
-    }
-  }
-}
-
-void LedDance();
-void FadeLeds();
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// LED helper functions
+
+#pragma once
+#include <stdint.h>
+#include "hal.h"
+#include "hardware_config.h"
+
+namespace clkr {
+enum LEDs {
+  LED_CLOCK, // PD5
+  LED_PAUSE  // PD6
+};
+
+enum LedBrightness {
+  BRIGHTNESS_NONE = 0x00,
+  BRIGHTNESS_HALF = 0x7F,
+  BRIGHTNESS_FULL = 0xFF
+};
+
+inline void PWMOff(LEDs led) { hal::LedPwm::Enable(led, false); }
+
+inline void PWMOn(LEDs led) { hal::LedPwm::Enable(led, true); }
+
+// Last brightness written to each LED
+extern uint8_t led_brightness[2];
+
+// Only touches the PWM registers when the brightness changes
+inline void LedSetBrightness(LEDs led, uint8_t brightness) {
+  if (brightness == led_brightness[led]) {
+    return;
+  }
+  led_brightness[led] = brightness;
+  if (brightness <= 0) {
+    PWMOff(led);
+  } else {
+    PWMOn(led);
+    hal::LedPwm::Write(led, brightness);
+  }
+}
+
+// One step of an LED pattern. Either jumps to the given brightnesses or
+// fades to them in a straight line, over duration (at least 1) sequencer
+// steps.
+struct LedKeyframe {
+  uint8_t clock;
+  uint8_t pause;
+  uint8_t duration;
+  bool fade;
+};
+
+struct LedPattern {
+  const LedKeyframe *keyframes; // In program memory
+  uint8_t size;
+  bool loop;
+};
+
+// Both LEDs swapping back and forth, entering or leaving the settings
+extern const LedPattern kLedDance;
+// Both LEDs breathing together, waiting for a setting to be edited
+extern const LedPattern kLedBreathe;
+
+/**
+ * @brief Plays LED patterns a step at a time from a main loop task, so they
+ *        never hold anything else up
+ *
+ * Step() runs every kStepPeriod milliseconds. It only reads a keyframe when
+ * the previous one is over, and the LEDs only get written when their
+ * brightness actually changes.
+ */
+class LedSequencer {
+public:
+  static const uint8_t kStepPeriod = 1;
+
+  static void Play(const LedPattern &pattern);
+  static inline void Stop() { playing_ = false; }
+
+  // False once a pattern that doesn't loop is over
+  static inline bool playing() { return playing_; }
+
+  static void Step();
+
+private:
+  static const LedKeyframe *keyframes_;
+  static uint8_t size_;
+  static bool loop_;
+  static uint8_t index_;
+  static uint8_t remaining_;
+  static uint8_t target_[2];
+  static uint16_t level_[2]; // 8.8 fixed point
+  static int16_t slope_[2];
+  static bool playing_;
+
+  DISALLOW_COPY_AND_ASSIGN(LedSequencer);
+};
 }
\ No newline at end of file
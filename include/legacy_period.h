@@ -0,0 +1,59 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Legacy mode period from the rate pot and CV.
+
+#pragma once
+#include <stdint.h>
+
+#include "clock.h"
+#include "hal.h"
+#include "resources.h"
+
+namespace clkr {
+
+/**
+ * @brief Legacy half period for a position along one of the LegacyCurves
+ *
+ * Positions run from 0 (slowest) to kInputRange (fastest), about 10 bits,
+ * and fall between two of the curve's knots, kSegmentSize positions apart,
+ * which are interpolated in fixed point. Only a change of curve or position
+ * costs an interpolation, the period is kept for the next call otherwise.
+ */
+class LegacyPeriod {
+public:
+  static const uint8_t kSegmentBits = 5;
+  static const uint16_t kSegmentSize = 1 << kSegmentBits;
+  static const uint16_t kInputRange = (kLegacyKnots - 1) * kSegmentSize;
+
+  // Position of a full scale 16-bit reading, 0 to kInputRange
+  static inline uint16_t Position(uint16_t reading) {
+    return (static_cast<uint32_t>(reading) * (kInputRange + 1)) >> 16;
+  }
+
+  // Half period in clk/8 steps
+  static uint32_t Compute(LegacyCurve curve, uint16_t position);
+
+private:
+  static LegacyCurve curve_;
+  static uint16_t position_;
+  static uint32_t period_;
+
+  DISALLOW_COPY_AND_ASSIGN(LegacyPeriod);
+};
+
+} // namespace clkr
@@ -0,0 +1,225 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Compile time lookup table generation.
+//
+// Tables are filled in by the compiler from a generator, a class with a
+// static constexpr Value(index), so they always match the constants they are
+// derived from and can be resized or retyped in one place. Everything sticks
+// to C++11 constexpr, one return statement per function.
+
+#pragma once
+#include <stdint.h>
+
+namespace clkr {
+namespace lut {
+
+template <uint16_t... indices> struct IndexSequence {};
+
+template <uint16_t size, uint16_t... indices>
+struct MakeIndexSequence : MakeIndexSequence<size - 1, size - 1, indices...> {};
+
+template <uint16_t... indices> struct MakeIndexSequence<0, indices...> {
+  typedef IndexSequence<indices...> type;
+};
+
+// A table that can be built by a constexpr function, and put in PROGMEM
+template <typename T, uint16_t size> struct Table {
+  T values[size];
+};
+
+template <typename Generator, uint16_t... indices>
+constexpr Table<typename Generator::value_type, sizeof...(indices)>
+MakeTable(IndexSequence<indices...>) {
+  return {{Generator::Value(indices)...}};
+}
+
+// Table of Generator::Value(0) to Value(Generator::kSize - 1)
+template <typename Generator>
+constexpr Table<typename Generator::value_type, Generator::kSize> MakeTable() {
+  return MakeTable<Generator>(
+      typename MakeIndexSequence<Generator::kSize>::type());
+}
+
+// Fixed point math. avr-gcc's double is only 32 bits wide, so everything is
+// done in unsigned 4.60 fixed point, which gives the same tables on the
+// module as on the host.
+
+typedef uint64_t Fixed;
+const uint8_t kFractionalBits = 60;
+const Fixed kOne = static_cast<Fixed>(1) << kFractionalBits;
+const Fixed kLow30 = (static_cast<Fixed>(1) << 30) - 1;
+
+// a * b, from the products of their 30 bit halves. The result must be below
+// 16, the low order product is dropped.
+constexpr Fixed Mul(Fixed a, Fixed b) {
+  return (a >> 30) * (b >> 30) + (((a >> 30) * (b & kLow30)) >> 30) +
+         (((a & kLow30) * (b >> 30)) >> 30);
+}
+
+constexpr Fixed RatioBits(uint64_t remainder, uint64_t denominator,
+                          Fixed bits, uint8_t count) {
+  return count == 0 ? bits
+                    : RatioBits(remainder * 2 >= denominator
+                                    ? remainder * 2 - denominator
+                                    : remainder * 2,
+                                denominator,
+                                bits * 2 + (remainder * 2 >= denominator),
+                                count - 1);
+}
+
+// numerator / denominator, which must be below 16, by long division.
+// The denominator must be below 2^63.
+constexpr Fixed Ratio(uint64_t numerator, uint64_t denominator) {
+  return ((numerator / denominator) << kFractionalBits) +
+         RatioBits(numerator % denominator, denominator, 0, kFractionalBits);
+}
+
+constexpr Fixed ExpSeries(Fixed x, Fixed term, Fixed sum, uint8_t n) {
+  return term == 0 ? sum
+                   : ExpSeries(x, Mul(term, x) / (n + 1),
+                               n % 2 ? sum - term : sum + term, n + 1);
+}
+
+// e^-x, from its series once x is halved down to 1/2 or less
+constexpr Fixed ExpNeg(Fixed x) {
+  return x > kOne / 2 ? Mul(ExpNeg(x / 2), ExpNeg(x / 2))
+                      : ExpSeries(x, kOne, 0, 0);
+}
+
+constexpr Fixed AtanhSeries(Fixed z2, Fixed power, Fixed sum, uint16_t n) {
+  return power == 0 ? sum
+                    : AtanhSeries(z2, Mul(power, z2), sum + power / n, n + 2);
+}
+
+// ln(numerator / denominator), for numerator > denominator, as
+// 2 atanh((n - d) / (n + d))
+constexpr Fixed Log(uint64_t numerator, uint64_t denominator) {
+  return 2 * AtanhSeries(Mul(Ratio(numerator - denominator,
+                                   numerator + denominator),
+                             Ratio(numerator - denominator,
+                                   numerator + denominator)),
+                         Ratio(numerator - denominator,
+                               numerator + denominator),
+                         0, 1);
+}
+
+// (span * numerator / denominator) rounded, for span below 2^24
+constexpr uint32_t Scale(uint32_t span, Fixed numerator, Fixed denominator) {
+  return (span * (numerator >> 20) + (denominator >> 21)) /
+         (denominator >> 20);
+}
+
+// Generators
+
+/**
+ * @brief Straight line from first to last, over size entries
+ */
+template <typename T, uint16_t size, uint32_t first, uint32_t last>
+struct Linear {
+  typedef T value_type;
+  static const uint16_t kSize = size;
+
+  static constexpr T Value(uint16_t i) {
+    return first > last
+               ? first - (static_cast<uint64_t>(first - last) * i +
+                          (size - 1) / 2) / (size - 1)
+               : first + (static_cast<uint64_t>(last - first) * i +
+                          (size - 1) / 2) / (size - 1);
+  }
+};
+
+/**
+ * @brief Exponential curve from first to last, over size entries, that is
+ *        midpoint of the way there halfway along
+ *
+ * With b = (1 / midpoint - 1)^2 entry i is first + (last - first) *
+ * (1 - b^x) / (1 - b), for x from 0 to 1 (electronics.stackexchange.com
+ * answer 341052). The midpoint is given in thousandths.
+ */
+template <typename T, uint16_t size, uint32_t first, uint32_t last,
+          uint16_t midpoint>
+struct Exponential {
+  // Much past 950 the log series needs too many terms
+  static_assert(midpoint > 500 && midpoint <= 950, "midpoint out of range");
+  static_assert((first > last ? first - last : last - first) < (1UL << 24),
+                "range too wide");
+
+  typedef T value_type;
+  static const uint16_t kSize = size;
+
+  // -ln(b)
+  static constexpr Fixed LogBase() {
+    return 2 * Log(midpoint, 1000 - midpoint);
+  }
+
+  static constexpr uint32_t Offset(uint16_t i) {
+    return Scale(first > last ? first - last : last - first,
+                 kOne - ExpNeg(LogBase() / (size - 1) * i),
+                 kOne - ExpNeg(LogBase()));
+  }
+
+  static constexpr T Value(uint16_t i) {
+    return first > last ? first - Offset(i) : first + Offset(i);
+  }
+};
+
+/**
+ * @brief Another generator's entries, last to first
+ */
+template <typename Generator> struct Reversed {
+  typedef typename Generator::value_type value_type;
+  static const uint16_t kSize = Generator::kSize;
+
+  static constexpr value_type Value(uint16_t i) {
+    return Generator::Value(kSize - 1 - i);
+  }
+};
+
+/**
+ * @brief Gaussian bump over size entries, peaking at amplitude in the middle
+ *        and falling off with a standard deviation of width thousandths of
+ *        the table, rounded down
+ */
+template <typename T, uint16_t size, uint8_t amplitude, uint16_t width>
+struct Gaussian {
+  typedef T value_type;
+  static const uint16_t kSize = size;
+
+  // ((i / size - 1/2) / (width / 1000))^2 / 2, for distance = |2i - size|
+  static constexpr uint64_t Numerator(uint32_t distance) {
+    return static_cast<uint64_t>(distance) * distance * 125000;
+  }
+  static constexpr uint64_t Denominator() {
+    return static_cast<uint64_t>(size) * size * width * width;
+  }
+
+  static constexpr T Level(uint32_t distance) {
+    return Numerator(distance) >= 16 * Denominator()
+               ? 0
+               : (amplitude *
+                  (ExpNeg(Ratio(Numerator(distance), Denominator())) >> 8)) >>
+                     (kFractionalBits - 8);
+  }
+
+  static constexpr T Value(uint16_t i) {
+    return Level(2UL * i > size ? 2UL * i - size : size - 2UL * i);
+  }
+};
+
+} // namespace lut
+} // namespace clkr
@@ -0,0 +1,100 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Pause engine.
+
+#pragma once
+#include <stdint.h>
+
+#include "clock.h"
+#include "hal.h"
+#include "timebase.h"
+
+namespace clkr {
+
+// What the output needs doing as a pause ends
+enum PauseAction {
+  PAUSE_ACTION_NONE,    // nothing yet, Gate() lets it through later
+  PAUSE_ACTION_FOLLOW,  // drive the output from the clock again, right away
+  PAUSE_ACTION_RESTART, // restart the clock from the top of the beat
+};
+
+/**
+ * @brief Mutes the clock output while paused, and picks it up again
+ *
+ * The pause CV's pin change interrupt forces the output low itself and then
+ * calls Hold(), so gate off follows the CV within the interrupt's latency
+ * instead of waiting for the next tick. Whatever drives the output from the
+ * clock passes its level through Gate(), which keeps it low until the pause
+ * is over.
+ *
+ * Release() ends the pause in the RestartMode asked for. A pause shorter
+ * than kGlitchFilter is taken for a glitch on the CV: it is let go of as if
+ * it never happened, without a restart, and a contact bouncing on the way
+ * back to a resume is treated the same way.
+ */
+class Pause {
+public:
+  Pause() {}
+  ~Pause() {}
+
+  // Pauses shorter than this are glitches, in Timer1 counts
+  static const uint32_t kGlitchFilter = Timebase::FromMicros(1000);
+
+  // Mute the output, with it already forced low and interrupts disabled
+  static inline void Hold(uint32_t time) {
+    if (state_ == STATE_HELD) {
+      return;
+    }
+    resume_state_ = state_;
+    state_ = STATE_HELD;
+    held_at_ = time;
+  }
+
+  // End a pause, with interrupts disabled
+  static PauseAction Release(uint32_t time, RestartMode mode);
+
+  // From the interrupt that drives the output, with the clock's level and
+  // whether a rising level starts a beat. Returns the level to drive.
+  static inline bool Gate(bool level, bool beat) {
+    if (state_ == STATE_ARMED && level && !last_level_ &&
+        (beat || !wait_for_beat_)) {
+      state_ = STATE_RUNNING;
+    }
+    last_level_ = level;
+    return level && state_ == STATE_RUNNING;
+  }
+
+  // Held by the CV or the button
+  static inline bool paused() { return state_ == STATE_HELD; }
+
+private:
+  enum State {
+    STATE_RUNNING,
+    STATE_HELD,
+    STATE_ARMED, // released, waiting for a pulse or beat to start on
+  };
+
+  static volatile State state_;
+  static State resume_state_;
+  static uint32_t held_at_;
+  static bool wait_for_beat_;
+  static bool last_level_;
+
+  DISALLOW_COPY_AND_ASSIGN(Pause);
+};
+
+} // namespace clkr
@@ -0,0 +1,138 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Interrupt handler profiling, for the clkr_profile build.
+
+#pragma once
+#include <stdint.h>
+
+#include "hal.h"
+
+namespace clkr {
+
+enum ProfiledIsr {
+  PROFILE_TICK,     // TIMER1_COMPA_vect
+  PROFILE_EDGE,     // TIMER1_COMPB_vect
+  PROFILE_PAUSE_CV, // PCINT1_vect
+  PROFILE_LAST
+};
+
+// Timings of one interrupt handler, in Timer1 counts (CPU cycles)
+struct IsrProfile {
+  uint32_t count;
+  uint32_t total;
+  uint16_t min;
+  uint16_t max;
+  // Longest wait from the compare match to the handler's first line
+  uint16_t max_latency;
+  // Times the handler's next interrupt came due before it was done
+  uint16_t overruns;
+};
+
+// What Dump() writes to the top of the EEPROM: the magic "CLKP", a version
+// byte, the number of handlers, then an IsrProfile for each.
+struct ProfileHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t num_isrs;
+};
+
+#ifdef CLKR_PROFILE
+// Bytes kept clear of the settings journal for the dump
+const uint16_t kProfileEepromSize = 64;
+#else
+const uint16_t kProfileEepromSize = 0;
+#endif
+
+/**
+ * @brief Execution time, latency and overrun statistics of the Timer1 and
+ *        pin change interrupt handlers
+ *
+ * Each profiled handler samples TCNT1 as it starts and as it returns.
+ * Execution times are wall time, so the tick handler's include whatever
+ * preempts it once it has re-enabled interrupts. Latency is measured from
+ * the compare match that fired the handler; the pin change handler has no
+ * such reference and reports none. An overrun is counted when a handler is
+ * entered again before it returned, or returns with its own interrupt
+ * already pending again.
+ *
+ * The statistics live in profile_ in RAM, behind a ProfileHeader, where a
+ * debugger or simavr can find them by the magic. Dump() copies them into
+ * the last kProfileEepromSize bytes of the EEPROM for reading back off a
+ * module with avrdude.
+ */
+class Profiler {
+public:
+  static const uint8_t kVersion = 1;
+  static const uint16_t kEepromAddress = hal::kEepromSize - kProfileEepromSize;
+  static const uint8_t kDumpSize =
+      sizeof(ProfileHeader) + PROFILE_LAST * sizeof(IsrProfile);
+
+  // With interrupts disabled, as the handler starts
+  static void Enter(ProfiledIsr isr, uint16_t entry, uint16_t due);
+  static void Exit(ProfiledIsr isr, uint16_t entry);
+
+  // From the main loop. Dump() takes a snapshot and Poll() writes it out
+  // through the EepromWriter whenever that has nothing else to do.
+  static void Dump();
+  static void Poll();
+
+private:
+  struct Block {
+    ProfileHeader header;
+    IsrProfile isrs[PROFILE_LAST];
+  };
+
+  static Block profile_;
+  static uint8_t active_;
+  static IsrProfile snapshot_[PROFILE_LAST];
+  static uint8_t dump_offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(Profiler);
+};
+
+// Times the rest of the enclosing handler, on every way out of it
+class ProfileScope {
+public:
+  ProfileScope(ProfiledIsr isr, uint16_t due)
+      : isr_(isr), entry_(hal::TickTimer::now()) {
+    Profiler::Enter(isr_, entry_, due);
+  }
+  explicit ProfileScope(ProfiledIsr isr)
+      : isr_(isr), entry_(hal::TickTimer::now()) {
+    Profiler::Enter(isr_, entry_, entry_);
+  }
+  ~ProfileScope() { Profiler::Exit(isr_, entry_); }
+
+private:
+  ProfiledIsr isr_;
+  uint16_t entry_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProfileScope);
+};
+
+} // namespace clkr
+
+// First thing in a handler, with the Timer1 count of the compare match that
+// fired it where there is one. Compiles to nothing without CLKR_PROFILE.
+#ifdef CLKR_PROFILE
+#define PROFILE_ISR(isr) clkr::ProfileScope profile_scope(isr)
+#define PROFILE_ISR_DUE(isr, due) clkr::ProfileScope profile_scope(isr, due)
+#else
+#define PROFILE_ISR(isr)
+#define PROFILE_ISR_DUE(isr, due)
+#endif
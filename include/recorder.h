@@ -0,0 +1,170 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Input event recorder, for the clkr_recorder build.
+
+#pragma once
+#include <stdint.h>
+
+#include "hal.h"
+#include "hardware_config.h"
+#include "profiler.h"
+
+namespace clkr {
+
+struct Settings;
+
+// The input log is a stream of these codes, each followed by the bytes
+// noted, multi-byte values little endian. Every event happens at the tick
+// reached by the waits before it.
+enum LogCode {
+  LOG_WAIT = 0x00,      // 00tttttt: t ticks later, 1-63
+  LOG_ADC_DELTA = 0x40, // 01ccdddd: slot c reads d steps more, -8-7
+  LOG_ADC = 0x80,       // 10cc0000, reading: slot c reads this
+  LOG_BUTTON = 0xb0,    // 1011000l: the button reads l
+  LOG_PAUSE_CV = 0xb2,  // 1011001l, counts: the Pause CV went to l, this
+                        // many Timer1 counts after the tick
+  LOG_SETTINGS = 0xb4,  // 10110100, Settings: loaded at boot, or saved
+  LOG_LONG_WAIT = 0xb5, // 10110101, ticks: this many ticks later
+  LOG_ADC_STEP = 0xc0,  // 11ccdddd: a millisecond later, as LOG_ADC_DELTA
+};
+
+// ADC channels in the log, by slot. Readings change by multiples of
+// hal::Adc::kReadingStep, which deltas count in.
+const uint8_t kNumLoggedChannels = 3;
+const uint8_t kLoggedChannels[kNumLoggedChannels] = {
+    ADC_CHANNEL_TEMPO, ADC_CHANNEL_SELECTOR, ADC_CHANNEL_TEMPO_CV};
+
+// What Dump() writes to the EEPROM: the magic "CLKI", a version byte,
+// whether the log filled up, and its length in bytes, which follow.
+struct LogHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t full;
+  uint16_t length;
+};
+
+const uint8_t kLogVersion = 1;
+
+#ifdef CLKR_RECORDER
+// Bytes kept clear of the settings journal for the dump
+const uint16_t kRecorderEepromSize = 768;
+
+/**
+ * @brief Log of everything the firmware reads from the outside world, for
+ *        replaying a run on the host
+ *
+ * The clock engine is deterministic, so its inputs and the ticks they
+ * arrived on are enough to play a run back through the native simulator
+ * and get the same output edges (see src/native/replay.cpp). Logged are
+ * the ADC readings as the main loop takes them, the button level as the
+ * tick interrupt debounces it, the Pause CV edges to the Timer1 count, and
+ * the settings the clock boots with and saves.
+ *
+ * Everything is logged only as it changes, as a delta from the previous
+ * value where that fits a byte, and time goes by in waits between events.
+ * A module left alone costs nothing until something changes, a button
+ * press or Pause CV edge three or four bytes, but a pot that turns, or
+ * flickers in its last bit, costs a byte for every millisecond scan that
+ * sees it move.
+ *
+ * Replay has to start from power on, the only state the host can know, so
+ * the log starts at boot and stops once kLogSize bytes are used rather
+ * than wrapping round. Dump() copies it into kRecorderEepromSize bytes of
+ * the EEPROM, below the profiler's, for reading back off a module with
+ * avrdude.
+ */
+class Recorder {
+public:
+  static const uint16_t kEepromAddress =
+      hal::kEepromSize - kProfileEepromSize - kRecorderEepromSize;
+  static const uint16_t kLogSize = kRecorderEepromSize - sizeof(LogHeader);
+
+  // From Init(), once the clock has loaded its settings and the timebase
+  // is counting. Starts the log over with them.
+  static void Start(const Settings &settings);
+
+  // From the main loop, as a reading is taken
+  static void Reading(uint8_t channel, uint16_t value);
+
+  // From the tick interrupt, as the button is read
+  static void ButtonLevel(uint8_t level);
+
+  // From the pin change interrupt, with the Timebase time of the edge
+  static void PauseCvEdge(bool level, uint32_t time);
+
+  // From the main loop, as settings are loaded or saved
+  static void SettingsChanged(const Settings &settings);
+
+  // From the main loop. Dump() closes the log at the current tick and
+  // Poll() writes it out through the EepromWriter whenever that has nothing
+  // else to do.
+  static void Dump();
+  static void Poll();
+
+private:
+  // Make room for a wait of ticks and size bytes after it, and write the
+  // wait. Returns false, and stops logging, if they don't fit.
+  static bool Begin(uint32_t ticks, uint8_t size);
+  static void Wait(uint32_t ticks);
+  static void Append(uint8_t value);
+  static void Append16(uint16_t value);
+
+  static LogHeader header_;
+  static LogHeader dump_header_;
+  static uint8_t log_[kLogSize];
+  static uint32_t last_tick_;
+  static uint16_t readings_[kNumLoggedChannels];
+  static uint8_t button_;
+  static uint16_t dump_length_;
+  static uint16_t dump_offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(Recorder);
+};
+
+// The ADC and button, logging every change as the firmware reads it
+template <typename Adc> struct RecordedAdc : Adc {
+  static inline uint16_t Read16(uint8_t channel) {
+    uint16_t value = Adc::Read16(channel);
+    Recorder::Reading(channel, value);
+    return value;
+  }
+  static inline uint8_t Read8(uint8_t channel) { return Read16(channel) >> 8; }
+};
+
+template <typename Button> struct RecordedButton : Button {
+  static inline uint8_t Read() {
+    uint8_t level = Button::Read();
+    Recorder::ButtonLevel(level);
+    return level;
+  }
+};
+
+#else
+const uint16_t kRecorderEepromSize = 0;
+#endif // CLKR_RECORDER
+
+} // namespace clkr
+
+// Compile to nothing without CLKR_RECORDER
+#ifdef CLKR_RECORDER
+#define RECORD_PAUSE_CV(level, time) clkr::Recorder::PauseCvEdge(level, time)
+#define RECORD_SETTINGS(settings) clkr::Recorder::SettingsChanged(settings)
+#else
+#define RECORD_PAUSE_CV(level, time)
+#define RECORD_SETTINGS(settings)
+#endif
@@ -0,0 +1,65 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Cooperative scheduler for the main loop.
+
+#pragma once
+#include <stdint.h>
+
+#include "hal.h"
+
+namespace clkr {
+
+struct Task {
+  void (*run)();
+  // Milliseconds between runs, 0 runs it on every pass
+  uint16_t period;
+};
+
+/**
+ * @brief Runs each of a fixed table of tasks when its period is up
+ *
+ * Tasks run to completion, in table order, so they never preempt each other.
+ * A task that falls behind runs once and picks up its period from then,
+ * rather than running again to catch up.
+ *
+ * @tparam num_tasks The size of the task table
+ */
+template <uint8_t num_tasks> class Scheduler {
+public:
+  explicit Scheduler(const Task (&tasks)[num_tasks]) : tasks_(tasks) {}
+  ~Scheduler() {}
+
+  // Run whatever is due at the given time, in milliseconds
+  void Poll(uint16_t now) {
+    for (uint8_t i = 0; i < num_tasks; ++i) {
+      // Wraps round every 65s, which is fine for periods well below that
+      if (static_cast<int16_t>(now - due_[i]) >= 0) {
+        due_[i] = now + tasks_[i].period;
+        tasks_[i].run();
+      }
+    }
+  }
+
+private:
+  const Task *tasks_;
+  uint16_t due_[num_tasks] = {};
+
+  DISALLOW_COPY_AND_ASSIGN(Scheduler);
+};
+
+} // namespace clkr
@@ -0,0 +1,111 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Settings journal, spread over the whole EEPROM.
+
+#pragma once
+#include <stdint.h>
+
+#include "eeprom_writer.h"
+#include "hal.h"
+#include "profiler.h"
+#include "recorder.h"
+
+namespace clkr {
+
+// Everything that survives a power cycle
+struct Settings {
+  uint8_t options; // Options::pack()
+  uint16_t tempo;  // In 1/16 BPM
+  uint8_t restart; // RestartMode
+};
+
+/**
+ * @brief Settings saved as a journal of checksummed records, written round
+ *        robin across the EEPROM
+ *
+ * Every save goes to the slot after the newest record, with the next
+ * sequence number, so each cell is only written about once every kNumSlots
+ * saves. The slot's version byte is cleared first, if it holds a valid one,
+ * and written last, so a save cut short by a power loss leaves an invalid
+ * slot and the record before it as the newest. The CRC catches anything
+ * else. At boot Load() reads every slot once and keeps the valid record with
+ * the highest sequence number.
+ *
+ * With no valid record the first save goes to slot 1. Slot 0 holds the
+ * settings of older firmware at 0x00 and 0x01, which have to stay intact
+ * until a record replaces them.
+ *
+ * Record layout, bytes past RECORD_RESTART are reserved for future fields and
+ * left erased (0xff):
+ *
+ *   0      format version
+ *   1-2    sequence number, little endian
+ *   3      options
+ *   4-5    tempo, little endian
+ *   6      restart mode, erased in records from older firmware
+ *   14-15  CRC-16 of bytes 0-13, little endian
+ */
+class SettingsJournal {
+public:
+  static const uint8_t kVersion = 1;
+  static const uint8_t kRecordSize = 16;
+  // Up to the space profiling and recording builds keep for their dumps
+  static const uint8_t kNumSlots =
+      (hal::kEepromSize - kProfileEepromSize - kRecorderEepromSize) /
+      kRecordSize;
+
+  // Find the newest valid record. Returns false if there is none, and the
+  // next save then goes to slot 1.
+  static bool Load(Settings *settings);
+
+  // From the main loop, queue a save. Later saves replace it until Poll()
+  // starts writing it.
+  static void Save(const Settings &settings);
+
+  // From the main loop, move the queued save on to the EepromWriter as the
+  // previous writes finish
+  static void Poll();
+
+private:
+  enum RecordField {
+    RECORD_VERSION = 0,
+    RECORD_SEQUENCE = 1,
+    RECORD_OPTIONS = 3,
+    RECORD_TEMPO = 4,
+    RECORD_RESTART = 6,
+    RECORD_CRC = kRecordSize - 2,
+  };
+
+  static uint16_t Crc(const uint8_t *record);
+  // Queue record_ at address, with its version last
+  static void WriteRecord(uint16_t address);
+
+  static uint8_t slot_;
+  static uint16_t sequence_;
+  static Settings settings_;
+  static bool pending_;
+  static bool committing_;
+  static uint8_t record_[kRecordSize];
+
+  static_assert(kRecordSize <= EepromWriter::kQueueSize,
+                "a record has to fit in the EEPROM write queue");
+
+  DISALLOW_COPY_AND_ASSIGN(SettingsJournal);
+};
+
+} // namespace clkr
@@ -0,0 +1,125 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// External clock sync.
+//
+// Rising edges on the sync input are timestamped by the Timebase and fed to
+// a second order (PI) phase
+// locked loop. The loop's oscillator is the start time and length of one
+// input pulse in CPU cycles. While it runs, the Grids output edges are placed
+// on fractions of that oscillator instead of the tempo pot, so a 4 PPQN
+// master comes out multiplied up to the selected resolution, edge for edge
+// in phase with it.
+//
+// The first edge starts a measurement, the second one gives the period and
+// restarts the output on the beat, and the loop takes it from there. With no
+// edge for two input periods, sync drops out and the pot takes over again.
+
+#pragma once
+#include "clock.h"
+#include "hal.h"
+#include "timebase.h"
+
+#ifndef CLKR_SYNC_PPQN
+#define CLKR_SYNC_PPQN 4
+#endif
+
+namespace clkr {
+
+class SyncPll {
+public:
+  SyncPll() {}
+  ~SyncPll() {}
+
+  // Pulses per quarter note expected on the sync input
+  static const uint8_t kInputPpqn = CLKR_SYNC_PPQN;
+  static const uint8_t kHalfPulsesPerInput = kPulsesPerBeat * 2 / kInputPpqn;
+
+  // Input periods outside 20-480 BPM are ignored, in CPU cycles
+  static const uint32_t kMinimumPeriod = F_CPU * 60 / (480L * kInputPpqn);
+  static const uint32_t kMaximumPeriod = F_CPU * 60 / (20L * kInputPpqn);
+
+  // Loop gains, as right shifts of the phase error. The phase of the
+  // oscillator takes half of each error, its period an eighth.
+  static const uint8_t kPhaseShift = 1;
+  static const uint8_t kFrequencyShift = 3;
+
+  // Phase errors within 1/64th of a period for this many input edges in a
+  // row count as locked
+  static const uint8_t kLockShift = 6;
+  static const uint8_t kLockCount = 4;
+
+  static void Init();
+
+  // To be called on every control rate tick, after Timebase::Tick()
+  static inline void Tick() {
+    if (active_ && Timebase::now() - last_edge_ > timeout_) {
+      active_ = false;
+      measuring_ = false;
+      lock_count_ = 0;
+    }
+  }
+
+  // Feed a rising edge on the sync input, from its pin change interrupt.
+  // Returns true when sync has just been acquired and the output should be
+  // restarted on this beat, with Align().
+  static bool Edge(uint32_t time);
+
+  // Line the oscillator up with the first output edge after a restart,
+  // scheduled at the given Timer1 count
+  static void Align(uint16_t first_edge);
+
+  // Cycles until the next output edge, num_half_pulses halves of a
+  // kPulsesPerBeat pulse after the previous one. Stands in for Clock::NextEdgeInterval()
+  // while sync is active.
+  static uint32_t NextEdgeInterval(uint8_t num_half_pulses,
+                                   uint32_t minimum_interval);
+
+  // Tempo of the input, in 1/16 BPM steps
+  static uint16_t tempo();
+
+  static inline bool active() { return active_; }
+  static inline bool locked() { return lock_count_ >= kLockCount; }
+
+  // Phase error at the latest input edge, in CPU cycles
+  static inline int32_t error() { return error_; }
+
+private:
+  static uint32_t last_edge_;
+  static uint32_t timeout_;
+  static bool measuring_;
+  static bool active_;
+  static uint8_t lock_count_;
+  static int32_t error_;
+
+  // The oscillator: start of the current input pulse in cycles, and the
+  // pulse length in cycles, 28.4 fixed point
+  static uint32_t beat_start_;
+  static uint8_t beat_fraction_;
+  static uint32_t period_;
+
+  // Length of half a kPulsesPerBeat pulse, 28.4 fixed point
+  static uint32_t step_;
+
+  // Half pulses from the start of the current input pulse to the last
+  // output edge, and the time of that edge
+  static uint8_t position_;
+  static uint32_t last_target_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyncPll);
+};
+
+} // namespace clkr
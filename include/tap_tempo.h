@@ -0,0 +1,65 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Tap tempo estimator.
+//
+// Taps come in as button events, timestamped by the Timebase in the
+// interrupt that saw them. The intervals between the last few taps are
+// kept in a small ring buffer, and the tempo comes from their median,
+// dropping any more than a quarter away from it (a missed or doubled tap)
+// and averaging the rest. This all runs in the main loop.
+
+#pragma once
+#include "clock.h"
+#include "hal.h"
+#include "timebase.h"
+
+namespace clkr {
+
+enum TapTempoResult {
+  TAP_TEMPO_NONE,   // Too soon after the previous tap, ignored
+  TAP_TEMPO_UNLOCK, // First tap of a new sequence
+  TAP_TEMPO_UPDATE, // New tempo estimate
+};
+
+class TapTempo {
+public:
+  TapTempo() {}
+  ~TapTempo() {}
+
+  // Intervals kept for the estimate (the last 8 taps)
+  static const uint8_t kNumIntervals = 7;
+
+  // Taps further apart than 30 BPM start a new sequence, and ones closer
+  // than 480 BPM are ignored, in Timer1 counts
+  static const uint32_t kMaximumInterval = Timebase::FromMillis(60000 / 30);
+  static const uint32_t kMinimumInterval = Timebase::FromMillis(60000 / 480);
+
+  // Record a tap at the given Timebase time. Once the sequence has an
+  // interval, the tempo is set in 1/16 BPM steps.
+  static TapTempoResult Tap(uint32_t time, uint16_t *tempo);
+
+private:
+  static bool started_;
+  static uint32_t last_tap_;
+  static uint32_t intervals_[kNumIntervals];
+  static uint8_t head_;
+  static uint8_t num_intervals_;
+
+  DISALLOW_COPY_AND_ASSIGN(TapTempo);
+};
+
+} // namespace clkr
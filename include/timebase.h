@@ -0,0 +1,109 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Monotonic timebase.
+
+#pragma once
+#include <stdint.h>
+
+#include "clock.h"
+#include "hal.h"
+
+namespace clkr {
+
+/**
+ * @brief Time since boot, from Timer1 extended in software by the tick
+ *
+ * Timer1 runs free at the CPU clock and the control rate tick interrupt
+ * comes round every tick_period counts of it, so adding the period up on
+ * every tick and the counts since the last one on top gives a 32-bit
+ * timestamp to the cycle, without an interrupt of its own. Everything that
+ * measures time (taps, long presses, settings timeouts, the sync input)
+ * takes it from here.
+ *
+ * Timestamps wrap every 3.5 minutes, so only ever compare differences.
+ */
+class Timebase {
+public:
+  static const uint32_t kCountsPerSecond = F_CPU / hal::kTimer1Prescaler;
+
+  // Start counting in step with the tick timer, once it is set up
+  static void Init(uint16_t tick_period);
+
+  // From the tick interrupt, before interrupts are enabled again
+  static inline void Tick(uint16_t tick_period) {
+    time_ += tick_period;
+    ++ticks_;
+  }
+
+  // Timer1 counts since Init(), atomically
+  static inline uint32_t now() {
+    hal::InterruptLock lock;
+    uint16_t last_tick = static_cast<uint16_t>(time_);
+    return time_ + static_cast<uint16_t>(hal::TickTimer::now() - last_tick);
+  }
+
+  // Timer1 counts since the last tick, atomically. Past a tick period if
+  // the tick interrupt is running late.
+  static inline uint16_t since_tick() {
+    hal::InterruptLock lock;
+    return hal::TickTimer::now() - static_cast<uint16_t>(time_);
+  }
+
+  // Control rate ticks since Init()
+  static inline uint32_t ticks() {
+    hal::InterruptLock lock;
+    return ticks_;
+  }
+
+  // Milliseconds since Init(), wrapping every 65s. Cheap enough for every
+  // pass of the main loop.
+  static inline uint16_t millis() { return ticks() / (kControlRate / 1000); }
+
+  // Timer1 counts in a time span
+  static constexpr uint32_t FromMicros(uint32_t micros) {
+    return micros * (kCountsPerSecond / 1000000);
+  }
+  static constexpr uint32_t FromMillis(uint32_t millis) {
+    return millis * (kCountsPerSecond / 1000);
+  }
+
+  // And back, by multiplying with a 0.32 fixed point reciprocal rather than
+  // dividing
+  static inline uint32_t ToMicros(uint32_t counts) {
+    return (static_cast<uint64_t>(counts) * kMicrosScale) >> 32;
+  }
+  static inline uint32_t ToMillis(uint32_t counts) {
+    return (static_cast<uint64_t>(counts) * kMillisScale) >> 32;
+  }
+
+private:
+  // 2^32 / counts per unit, rounded up so whole units come out whole
+  static const uint32_t kMicrosScale =
+      ((1ULL << 32) + kCountsPerSecond / 1000000 - 1) /
+      (kCountsPerSecond / 1000000);
+  static const uint32_t kMillisScale =
+      ((1ULL << 32) + kCountsPerSecond / 1000 - 1) /
+      (kCountsPerSecond / 1000);
+
+  static uint32_t time_;
+  static uint32_t ticks_;
+
+  DISALLOW_COPY_AND_ASSIGN(Timebase);
+};
+
+} // namespace clkr
@@ -1,31 +0,0 @@
-#!/usr/bin/python3
-#
-# Copyright 2012 Emilie Gillet.
-#
-# Author: Emilie Gillet (emilie.o.gillet@gmail.com)
-#
-# This program is free software: you can redistribute it and/or modify
-# it under the terms of the GNU General Public License as published by
-# the Free Software Foundation, either version 3 of the License, or
-# (at your option) any later version.
-# This program is distributed in the hope that it will be useful,
-# but WITHOUT ANY WARRANTY; without even the implied warranty of
-# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-# GNU General Public License for more details.
-# You should have received a copy of the GNU General Public License
-# along with this program.  If not, see <http://www.gnu.org/licenses/>.
-#
-# -----------------------------------------------------------------------------
-#
-# Lookup table definitions.
-
-import numpy
-
-"""----------------------------------------------------------------------------
-Phase increment for tempo.
-----------------------------------------------------------------------------"""
-
-control_rate = 8000
-width = 1 << 32
-tempo_values = numpy.arange(0, 512.0)
-lookup_tables32 = [('tempo_phase_increment', width * tempo_values * 8 / (60 * control_rate) / 2)]
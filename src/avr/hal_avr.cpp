@@ -0,0 +1,59 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Hardware abstraction layer, ATmega328P implementation.
+
+#ifdef __AVR__
+
+#include "hal.h"
+
+namespace clkr {
+namespace hal {
+
+/* static */
+uint8_t Adc::num_inputs_;
+
+/* static */
+uint8_t Adc::channel_;
+
+/* static */
+uint8_t Adc::count_;
+
+/* static */
+uint16_t Adc::accumulator_;
+
+/* static */
+volatile uint16_t Adc::readings_[kMaxInputs];
+
+/* static */
+void Adc::Init(uint8_t num_inputs) {
+  num_inputs_ = num_inputs;
+  channel_ = 0;
+  count_ = 0;
+  accumulator_ = 0;
+  ADMUX = _BV(REFS0);  // AVCC reference, right aligned, channel 0
+  ADCSRB = _BV(ADTS2); // Auto trigger on Timer0 overflow
+  // Enabled, auto triggered, interrupt on completion, clk/128 (156kHz)
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) |
+           _BV(ADPS0);
+}
+
+} // namespace hal
+} // namespace clkr
+
+ISR(ADC_vect) { clkr::hal::Adc::Convert(); }
+
+#endif // __AVR__
@@ -1,79 +1,146 @@
-// Copyright 2011 Emilie Gillet, 2022 Katherine Whitlock
-//
-// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
-//         Katherine Whitlock (kate@skylinesynths.nyc)
-//
-// This program is free software: you can redistribute it and/or modify
-// it under the terms of the GNU General Public License as published by
-// the Free Software Foundation, either version 3 of the License, or
-// (at your option) any later version.
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-// You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
-//
-// -----------------------------------------------------------------------------
-//
-// Global clock.
-
-#include "clock.h"
-
-#include "resources.h"
-#include <avr/eeprom.h>
-
-namespace clkr {
-
-Clock clock;
-
-/* static */
-Options Clock::options_;
-
-/* static */
-bool Clock::beat_;
-
-/* static */
-bool Clock::first_half_;
-
-/* static */
-uint8_t Clock::last_pulse_;
-
-/* static */
-uint8_t Clock::pulse_;
-
-/* static */
-uint16_t Clock::bpm_;
-
-/* static */
-uint32_t Clock::phase_;
-
-/* static */
-uint32_t Clock::phase_increment_;
-
-/* static */
-uint8_t Clock::falling_edge_;
-
-/* static */
-void Clock::Update(uint16_t bpm, ClockResolution resolution) {
-  bpm_ = bpm;
-  phase_increment_ = pgm_read_dword(lut_res_tempo_phase_increment + bpm);
-  if (resolution == CLOCK_RESOLUTION_4_PPQN) {
-    phase_increment_ >>= 1;
-  } else if (resolution == CLOCK_RESOLUTION_24_PPQN) {
-    phase_increment_ = (phase_increment_ << 1) + phase_increment_;
-  }
-}
-
-/* static */
-void Clock::LoadSettings() {
-  options_.unpack(eeprom_read_byte(NULL));
-  bpm_ = eeprom_read_byte((uint8_t*)0x01);
-}
-
-/* static */
-void Clock::SaveSettings() {
-  eeprom_write_byte(NULL, options_.pack());
-  eeprom_write_byte((uint8_t*)0x01, bpm_);
-}
+// Copyright 2011 Emilie Gillet, 2022 Katherine Whitlock
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//         Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Global clock.
+
+#include "clock.h"
+#include "recorder.h"
+#include "settings_journal.h"
+
+namespace clkr {
+
+Clock clock;
+
+/* static */
+Options Clock::options_;
+
+/* static */
+bool Clock::beat_;
+
+/* static */
+bool Clock::first_half_;
+
+/* static */
+uint8_t Clock::last_pulse_;
+
+/* static */
+uint8_t Clock::pulse_;
+
+/* static */
+uint16_t Clock::tempo_;
+
+/* static */
+uint32_t Clock::phase_;
+
+/* static */
+DoubleBuffer<ClockRate> Clock::rate_;
+
+/* static */
+uint8_t Clock::falling_edge_;
+
+/* static */
+uint8_t Clock::edge_fraction_;
+
+// Spot checks against the exact increments: these are never more than one
+// step short, which matches the old integer BPM table at 4 and 8 PPQN and
+// beats its tripled entries at 24 PPQN.
+static_assert(TempoScale<4>::PhaseIncrement(BpmToTempo(20)) == 357913,
+              "20 BPM at 4 PPQN");
+static_assert(TempoScale<8>::PhaseIncrement(BpmToTempo(120)) == 4294967,
+              "120 BPM at 8 PPQN");
+static_assert(TempoScale<24>::PhaseIncrement(BpmToTempo(480)) == 51539607,
+              "480 BPM at 24 PPQN");
+static_assert(TempoScale<96>::PhaseIncrement(BpmToTempo(480)) == 206158430,
+              "480 BPM at 96 PPQN");
+
+/* static */
+void Clock::Update(uint16_t tempo, ClockResolution resolution) {
+  ClockRate rate;
+  tempo_ = tempo;
+  switch (resolution) {
+  case CLOCK_RESOLUTION_4_PPQN:
+    rate.phase_increment = TempoScale<4>::PhaseIncrement(tempo);
+    break;
+  case CLOCK_RESOLUTION_8_PPQN:
+    rate.phase_increment = TempoScale<8>::PhaseIncrement(tempo);
+    break;
+  case CLOCK_RESOLUTION_48_PPQN:
+    rate.phase_increment = TempoScale<48>::PhaseIncrement(tempo);
+    break;
+  case CLOCK_RESOLUTION_96_PPQN:
+    rate.phase_increment = TempoScale<96>::PhaseIncrement(tempo);
+    break;
+  default:
+    rate.phase_increment = TempoScale<24>::PhaseIncrement(tempo);
+    break;
+  }
+
+  // Cycles per half pulse for the edge scheduler. The settings in EEPROM
+  // can hold anything, so keep well clear of a division by zero.
+  const uint32_t kHalfPulseCyclesAt1Bpm = F_CPU * 60L / (kPulsesPerBeat * 2);
+  if (tempo < BpmToTempo(20)) {
+    tempo = BpmToTempo(20);
+  }
+  const uint32_t kHalfPulseCycles = kHalfPulseCyclesAt1Bpm
+                                    << kTempoFractionalBits;
+  uint32_t cycles = kHalfPulseCycles / tempo;
+  uint32_t remainder = kHalfPulseCycles % tempo;
+  rate.edge_unit = (cycles << kEdgeFractionalBits) +
+                   (remainder << kEdgeFractionalBits) / tempo;
+
+  // The interrupts pick up both halves at once
+  rate_.Write(rate);
+}
+
+/* static */
+void Clock::LoadSettings() {
+  Settings settings;
+  if (SettingsJournal::Load(&settings)) {
+    options_.unpack(settings.options);
+    tempo_ = settings.tempo;
+    if (settings.restart < RESTART_LAST) {
+      options_.restart_mode = static_cast<RestartMode>(settings.restart);
+    }
+    return;
+  }
+
+  // Older firmware kept the options at 0x00 and whole BPM at 0x01. They
+  // move into the journal with the next save.
+  uint8_t legacy_options = hal::Eeprom::Read(0x00);
+  uint8_t legacy_bpm = hal::Eeprom::Read(0x01);
+  if (legacy_options != 0xff) {
+    options_.unpack(legacy_options);
+    if (legacy_bpm >= 20) {
+      tempo_ = BpmToTempo(legacy_bpm);
+    }
+  }
+}
+
+/* static */
+void Clock::SaveSettings() {
+  Settings saved = settings();
+  RECORD_SETTINGS(saved);
+  SettingsJournal::Save(saved);
+}
+
+/* static */
+Settings Clock::settings() {
+  Settings settings = {options_.pack(), tempo_, options_.restart_mode};
+  return settings;
+}
 }  // namespace grids
\ No newline at end of file
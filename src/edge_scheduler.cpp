@@ -0,0 +1,49 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Output edge scheduler.
+
+#include "edge_scheduler.h"
+
+namespace clkr {
+
+/* static */
+uint16_t EdgeScheduler::compare_;
+
+/* static */
+uint32_t EdgeScheduler::remaining_;
+
+/* static */
+bool EdgeScheduler::running_;
+
+/* static */
+void EdgeScheduler::Start(uint32_t interval) {
+  hal::InterruptLock lock;
+  compare_ = hal::EdgeTimer::now();
+  Next(interval);
+  hal::EdgeTimer::Enable(true);
+  running_ = true;
+}
+
+/* static */
+void EdgeScheduler::Stop() {
+  hal::InterruptLock lock;
+  hal::EdgeTimer::Enable(false);
+  running_ = false;
+}
+
+} // namespace clkr
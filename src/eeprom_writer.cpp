@@ -0,0 +1,78 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Background EEPROM writes, paced by the EEPROM ready interrupt.
+
+#include "eeprom_writer.h"
+
+namespace clkr {
+
+/* static */
+uint16_t EepromWriter::addresses_[kQueueSize];
+
+/* static */
+uint8_t EepromWriter::values_[kQueueSize];
+
+/* static */
+volatile uint8_t EepromWriter::count_;
+
+/* static */
+bool EepromWriter::Write(uint16_t address, uint8_t value) {
+  hal::InterruptLock lock;
+  uint8_t count = count_;
+  for (uint8_t i = 0; i < count; ++i) {
+    if (addresses_[i] == address) {
+      values_[i] = value;
+      return true;
+    }
+  }
+  if (count == kQueueSize) {
+    return false;
+  }
+  addresses_[count] = address;
+  values_[count] = value;
+  count_ = count + 1;
+  hal::Eeprom::EnableReadyInterrupt(true);
+  return true;
+}
+
+/* static */
+void EepromWriter::Ready() {
+  uint8_t count = count_;
+  uint8_t next = 0;
+  while (next < count &&
+         hal::Eeprom::Read(addresses_[next]) == values_[next]) {
+    ++next;
+  }
+  if (next < count) {
+    hal::Eeprom::StartWrite(addresses_[next], values_[next]);
+    ++next;
+  }
+
+  // Drop what was written or skipped
+  for (uint8_t i = next; i < count; ++i) {
+    addresses_[i - next] = addresses_[i];
+    values_[i - next] = values_[i];
+  }
+  count_ = count - next;
+  if (!count_) {
+    // Ready fires for as long as it is enabled and the EEPROM is idle
+    hal::Eeprom::EnableReadyInterrupt(false);
+  }
+}
+
+} // namespace clkr
@@ -1,59 +1,147 @@
-// Copyright 2023 Katherine Whitlock
-//
-// Author: Katherine Whitlock (kate@skylinesynths.nyc)
-//
-// This program is free software: you can redistribute it and/or modify
-// it under the terms of the GNU General Public License as published by
-// the Free Software Foundation, either version 3 of the License, or
-// (at your option) any later version.
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-// You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
-//
-// -----------------------------------------------------------------------------
-//
-// LED helper function implementations, primarily patterns
-
-#include "led.h"
-#include "resources.h"
-#include <avrlib/time.h>
-
-namespace clkr {
-void LedDance() {
-  LedSetBrightness(LED_CLOCK, BRIGHTNESS_FULL);
-  LedSetBrightness(LED_PAUSE, BRIGHTNESS_NONE);
-  for (int i = 0; i < 3; i++) {
-    ConstantDelay(150);
-    LedSetBrightness(LED_CLOCK, BRIGHTNESS_NONE);
-    LedSetBrightness(LED_PAUSE, BRIGHTNESS_FULL);
-    ConstantDelay(150);
-    LedSetBrightness(LED_CLOCK, BRIGHTNESS_FULL);
-    LedSetBrightness(LED_PAUSE, BRIGHTNESS_NONE);
-  }
-  LedSetBrightness(LED_CLOCK, BRIGHTNESS_NONE);
-  LedSetBrightness(LED_PAUSE, BRIGHTNESS_NONE);
-  LedSetBrightness(LED_CLOCK, BRIGHTNESS_FULL);
-  LedSetBrightness(LED_PAUSE, BRIGHTNESS_FULL);
-}
-
-void FadeLeds() {
-  static uint16_t fader_idx;
-  static uint32_t faderTimer;
-  uint8_t fader = pgm_read_byte(lut_res_gauss_curve + fader_idx);
-  LedSetBrightness(LED_CLOCK, fader);
-  LedSetBrightness(LED_PAUSE, fader);
-
-  if (faderTimer == 0) {
-    fader_idx += 1;
-    if (fader_idx >= LUT_RES_GAUSS_CURVE_SIZE) {
-      fader_idx = 0;
-    }
-    faderTimer = 45;
-  } else {
-    faderTimer--;
-  }
-}
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// LED helper function implementations, primarily patterns
+
+#include "led.h"
+#include "lookup_tables.h"
+
+namespace clkr {
+uint8_t led_brightness[2];
+
+static const LedKeyframe dance_keyframes[] PROGMEM = {
+    {BRIGHTNESS_FULL, BRIGHTNESS_NONE, 150, false},
+    {BRIGHTNESS_NONE, BRIGHTNESS_FULL, 150, false},
+    {BRIGHTNESS_FULL, BRIGHTNESS_NONE, 150, false},
+    {BRIGHTNESS_NONE, BRIGHTNESS_FULL, 150, false},
+    {BRIGHTNESS_FULL, BRIGHTNESS_NONE, 150, false},
+    {BRIGHTNESS_NONE, BRIGHTNESS_FULL, 150, false},
+};
+
+const LedPattern kLedDance = {dance_keyframes, 6, false};
+
+/**
+ * @brief The breathing pattern, a gaussian bump (the old 500 entry fader
+ *        curve) cut into num_keyframes straight segments over period ms
+ */
+template <uint8_t num_keyframes, uint16_t period> struct Breathe {
+  typedef LedKeyframe value_type;
+  static const uint16_t kSize = num_keyframes;
+  static const uint16_t kDuration =
+      period / num_keyframes / LedSequencer::kStepPeriod;
+  static_assert(kDuration > 0 && kDuration < 256,
+                "keyframe duration out of range");
+
+  static constexpr uint8_t Level(uint16_t i) {
+    return lut::Gaussian<uint8_t, num_keyframes, BRIGHTNESS_FULL, 140>::Value(
+        i % num_keyframes);
+  }
+
+  // Each keyframe fades to the next point on the curve
+  static constexpr LedKeyframe Value(uint16_t i) {
+    return {Level(i + 1), Level(i + 1), kDuration, true};
+  }
+};
+
+typedef Breathe<16, 2880> BreathePattern;
+static const lut::Table<LedKeyframe, BreathePattern::kSize> breathe_keyframes
+    PROGMEM = lut::MakeTable<BreathePattern>();
+
+const LedPattern kLedBreathe = {breathe_keyframes.values,
+                                BreathePattern::kSize, true};
+
+// Brightness to 8.8 fixed point
+static inline uint16_t Level(uint8_t brightness) {
+  return static_cast<uint16_t>(brightness) << 8;
+}
+
+/* static */
+const LedKeyframe *LedSequencer::keyframes_;
+
+/* static */
+uint8_t LedSequencer::size_;
+
+/* static */
+bool LedSequencer::loop_;
+
+/* static */
+uint8_t LedSequencer::index_;
+
+/* static */
+uint8_t LedSequencer::remaining_;
+
+/* static */
+uint8_t LedSequencer::target_[2];
+
+/* static */
+uint16_t LedSequencer::level_[2];
+
+/* static */
+int16_t LedSequencer::slope_[2];
+
+/* static */
+bool LedSequencer::playing_;
+
+/* static */
+void LedSequencer::Play(const LedPattern &pattern) {
+  keyframes_ = pattern.keyframes;
+  size_ = pattern.size;
+  loop_ = pattern.loop;
+  index_ = 0;
+  remaining_ = 0;
+  level_[LED_CLOCK] = Level(led_brightness[LED_CLOCK]);
+  level_[LED_PAUSE] = Level(led_brightness[LED_PAUSE]);
+  playing_ = true;
+}
+
+/* static */
+void LedSequencer::Step() {
+  if (!remaining_) {
+    if (index_ == size_) {
+      if (!loop_) {
+        playing_ = false;
+        return;
+      }
+      index_ = 0;
+    }
+
+    // Next keyframe
+    const LedKeyframe *keyframe = keyframes_ + index_++;
+    target_[LED_CLOCK] = pgm_read_byte(&keyframe->clock);
+    target_[LED_PAUSE] = pgm_read_byte(&keyframe->pause);
+    remaining_ = pgm_read_byte(&keyframe->duration);
+    bool fade = pgm_read_byte(&keyframe->fade);
+    for (uint8_t led = 0; led < 2; ++led) {
+      if (fade) {
+        int32_t distance =
+            static_cast<int32_t>(Level(target_[led])) - level_[led];
+        slope_[led] = distance / remaining_;
+      } else {
+        slope_[led] = 0;
+        level_[led] = Level(target_[led]);
+      }
+    }
+  }
+
+  --remaining_;
+  for (uint8_t led = 0; led < 2; ++led) {
+    // Land on the keyframe exactly, whatever the rounding on the way
+    level_[led] = remaining_ ? level_[led] + slope_[led] : Level(target_[led]);
+    LedSetBrightness(static_cast<LEDs>(led), level_[led] >> 8);
+  }
+}
 } // namespace clkr
\ No newline at end of file
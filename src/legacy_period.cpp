@@ -0,0 +1,61 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Legacy mode period from the rate pot and CV.
+
+#include "legacy_period.h"
+
+namespace clkr {
+
+// The curves only ever fall, and a segment's drop times the position within
+// it has to fit in 32 bits
+static_assert(kLegacySlowest < 0xffffffffUL / LegacyPeriod::kSegmentSize,
+              "legacy periods too long to interpolate");
+
+/* static */
+LegacyCurve LegacyPeriod::curve_;
+
+/* static */
+uint16_t LegacyPeriod::position_ = LegacyPeriod::kInputRange + 1;
+
+/* static */
+uint32_t LegacyPeriod::period_;
+
+/* static */
+uint32_t LegacyPeriod::Compute(LegacyCurve curve, uint16_t position) {
+  if (position > kInputRange) {
+    position = kInputRange;
+  }
+  if (curve == curve_ && position == position_) {
+    return period_;
+  }
+  curve_ = curve;
+  position_ = position;
+
+  const uint32_t *knot =
+      lut_res_legacy_knots[curve].values + (position >> kSegmentBits);
+  uint32_t from = pgm_read_dword(knot);
+  uint8_t fraction = position & (kSegmentSize - 1);
+  if (fraction) {
+    uint32_t to = pgm_read_dword(knot + 1);
+    from -= ((from - to) * fraction + kSegmentSize / 2) >> kSegmentBits;
+  }
+  period_ = from;
+  return period_;
+}
+
+} // namespace clkr
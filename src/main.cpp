@@ -1,488 +1,875 @@
-// Copyright 2012 Emilie Gillet, 2023 Katherine Whitlock
-//
-// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
-//         Katherine Whitlock (kate@skylinesynths.nyc)
-//
-// This program is free software: you can redistribute it and/or modify
-// it under the terms of the GNU General Public License as published by
-// the Free Software Foundation, either version 3 of the License, or
-// (at your option) any later version.
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-// You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
-
-#include "avrlib/adc.h"
-#include "avrlib/boot.h"
-#include "avrlib/gpio.h"
-#include "avrlib/op.h"
-#include "avrlib/time.h"
-#include "avrlib/watchdog_timer.h"
-#include "clock.h"
-#include "hardware_config.h"
-#include "led.h"
-#include "resources.h"
-#include "running_average.h"
-
-using namespace avrlib;
-using namespace clkr;
-
-// 625khz (1.6us) / 8000 = 78.125hz (12.8ms)
-constexpr uint8_t kUpdatePeriod = 20000000 / 64 / 8000;
-constexpr uint8_t kTimer2Period = 25;
-
-Gpio<PortB, 5> clockOut;
-DigitalInput<Gpio<PortB, 4>> button;
-DigitalInput<Gpio<PortC, 2>> selector;
-AdcInputScanner adc;
-
-enum Parameter {
-  PARAMETER_NONE,       // In main mode
-  PARAMETER_TRANSITION, // Entering/Leaving settings editor
-  PARAMETER_WAITING,    // In settings editor mode
-  PARAMETER_CLOCK_RESOLUTION,
-  PARAMETER_TAP_TEMPO, // or pause
-};
-
-enum SpeedMode {
-  MODE_FAST, // 0v corresponds to right position, and 5v to left position
-  MODE_SLOW, // ordered like this for ease of translation
-};
-
-volatile bool legacy_clock = LOW;
-
-// The overall state of the clock system,
-// in reality, whether the clock outputs are enabled or not
-enum RunState { STATE_RUNNING, STATE_PAUSED };
-
-uint32_t tap_duration = 0;
-
-volatile Parameter parameter = PARAMETER_NONE;
-volatile SpeedMode speed_mode = MODE_FAST;
-volatile RunState run_state = STATE_RUNNING;
-volatile bool long_press_detected = false;
-
-// This is how we count for the legacy system:
-// very fast, very frequent
-// Why do this instead of modifying the comparator?
-// Timer is only 16bits wide maximum (Timer1)
-// Maximum comparison for legacy is 6250000 (10 seconds)
-// which exceeds the 16bit width
-volatile uint32_t legacy_comparator;
-volatile uint32_t legacy_counter = 0;
-ISR(TIMER2_COMPA_vect) { legacy_counter += kTimer2Period; }
-
-inline void HandleClockInternalLegacy() {
-  // Legacy clock system
-  if (clock.legacy_mode() && legacy_counter >= legacy_comparator) {
-    legacy_counter = 0;
-    legacy_clock = !legacy_clock;
-  }
-}
-
-uint8_t led_pattern[2] = {0, 0};
-
-/* Update the LEDS to reflect the current state of the system. */
-inline void UpdateLeds() {
-  uint8_t clock_pwm = led_pattern[LED_CLOCK];
-  uint8_t pause_pwm = led_pattern[LED_PAUSE];
-
-  // We're not editing any parameters...
-  if (parameter == PARAMETER_NONE) {
-    clock_pwm = 0x00; // led_pattern[LED_CLOCK];
-    pause_pwm = 0x00; // led_pattern[LED_PAUSE];
-
-    // Clock LED
-    if (clock.legacy_mode()) {
-      clock_pwm = legacy_clock ? BRIGHTNESS_FULL : BRIGHTNESS_NONE;
-    } else { // Grids Mode
-      if (clock.on_first_half()) {
-        clock_pwm = BRIGHTNESS_FULL;
-
-        // If the clock is locked, (such as by tap tempo),
-        // also flash the pause light at the same time to
-        // give a "synchronized" appearance.
-        if (clock.locked()) {
-          pause_pwm = BRIGHTNESS_FULL;
-        }
-      }
-    }
-
-    // If we're paused, display such
-    if (run_state == STATE_PAUSED) {
-      pause_pwm = BRIGHTNESS_FULL;
-    }
-
-    LedSetBrightness(LED_CLOCK, clock_pwm);
-    LedSetBrightness(LED_PAUSE, pause_pwm);
-    led_pattern[LED_CLOCK] = clock_pwm;
-    led_pattern[LED_PAUSE] = pause_pwm;
-  } else if (parameter == PARAMETER_TRANSITION) {
-    // Swapping between modes
-  } else if (parameter == PARAMETER_WAITING) {
-    // WAITING for parameter to edit...
-    FadeLeds();
-  } else { // EDITing a parameter
-    clock_pwm = BRIGHTNESS_NONE;
-    pause_pwm = BRIGHTNESS_NONE;
-    switch (parameter) {
-    case PARAMETER_CLOCK_RESOLUTION: {
-      if (!clock.legacy_mode()) { // legacy mode is just all dark
-        auto clock_resolution = clock.clock_resolution();
-        if (clock_resolution == CLOCK_RESOLUTION_4_PPQN) {
-          clock_pwm = BRIGHTNESS_FULL;
-        } else if (clock_resolution == CLOCK_RESOLUTION_8_PPQN) {
-          pause_pwm = BRIGHTNESS_FULL;
-        } else if (clock_resolution == CLOCK_RESOLUTION_24_PPQN) {
-          clock_pwm = BRIGHTNESS_FULL;
-          pause_pwm = BRIGHTNESS_FULL;
-        }
-      }
-      break;
-    }
-
-    case PARAMETER_TAP_TEMPO:
-      if (clock.tap_tempo()) {
-        pause_pwm = BRIGHTNESS_FULL;
-      } else {
-        clock_pwm = BRIGHTNESS_FULL;
-      }
-      break;
-
-    default:
-      break;
-    }
-    LedSetBrightness(LED_CLOCK, clock_pwm);
-    LedSetBrightness(LED_PAUSE, pause_pwm);
-  }
-}
-
-/* Clock output signal function*/
-inline void UpdateClockOut() {
-  if (run_state == STATE_PAUSED) {
-    clockOut.set_value(LOW);
-    return;
-  }
-
-  // Legacy Mode
-  // No differentiation between FAST and SLOW here, it's
-  // handled by the changing timer prescaler in ScanPots()
-  if (clock.legacy_mode()) {
-    clockOut.set_value(legacy_clock);
-    return;
-  }
-
-  // Grids Mode
-  switch (speed_mode) {
-  // In the FAST mode, past_falling_edge and new_pulse
-  // determine the bounds of our square wave output
-  case MODE_FAST:
-    if (clock.past_falling_edge()) {
-      clockOut.set_value(LOW);
-    } else if (clock.new_pulse()) {
-      clockOut.set_value(HIGH);
-    }
-    break;
-
-  // But SLOW mode just follows the LED (50% duty cycle)
-  case MODE_SLOW:
-    if (clock.on_first_half()) {
-      clockOut.set_value(HIGH);
-    } else {
-      clockOut.set_value(LOW);
-    }
-    break;
-  }
-}
-
-uint8_t ticks_granularity[] = {6, 3, 1, 0};
-
-// This function is what actually pushes the system
-// forwards, called from the Grids timer's interrupt
-inline void HandleClockInternalGrids() {
-  uint8_t num_ticks = 0;
-  uint8_t increment = ticks_granularity[clock.clock_resolution()];
-
-  clock.Tick();
-  clock.Wrap(0); // No clock swing
-  if (clock.raising_edge()) {
-    num_ticks = increment;
-  }
-
-  if (num_ticks) {
-    clock.TickClock(num_ticks);
-  }
-}
-
-enum SwitchState {
-  SWITCH_STATE_JUST_PRESSED = 0x01,
-  SWITCH_STATE_PRESSED = 0xff,
-  SWITCH_STATE_JUST_RELEASED = 0xfe,
-  SWITCH_STATE_RELEASED = 0x00
-};
-
-inline void HandleTapButton() {
-  static uint8_t switch_state = 0x00; // default state is LOW
-  static uint16_t switch_hold_time = 0;
-
-  switch_state = switch_state << 1;
-  if (button.Read()) {
-    switch_state |= 1;
-  }
-
-  if (switch_state == SWITCH_STATE_JUST_PRESSED) {
-    if (parameter == PARAMETER_NONE) {
-      if (!clock.tap_tempo() || clock.legacy_mode()) {
-        // Act as a pause button
-        run_state = static_cast<RunState>(!run_state);
-        clock.Reset();
-      } else {
-        // Tap Tempo system
-        uint32_t new_bpm = (F_CPU * 60L) / (64 * kUpdatePeriod * tap_duration);
-        if (new_bpm >= 30 && new_bpm <= 480) {
-          clock.Update(new_bpm, clock.clock_resolution());
-          clock.Reset();
-          clock.Lock();
-          clock.SaveSettings();
-        } else {
-          clock.Unlock();
-          clock.SaveSettings();
-        }
-        tap_duration = 0;
-      }
-    }
-    switch_hold_time = 0;
-  } else if (switch_state == SWITCH_STATE_PRESSED) {
-    ++switch_hold_time;
-    if (switch_hold_time == 1000) {
-      long_press_detected = true;
-    }
-  }
-}
-
-// Interrupt for Timer1 (GRIDS MODE)
-ISR(TIMER1_COMPA_vect, ISR_NOBLOCK) {
-  static uint8_t switch_debounce_prescaler;
-
-  ++tap_duration;
-  ++switch_debounce_prescaler;
-  if (switch_debounce_prescaler >= 10) {
-    // Debounce RESET/TAP switch and perform switch action.
-    HandleTapButton();
-    switch_debounce_prescaler = 0;
-  }
-
-  if (clock.legacy_mode()) {
-    HandleClockInternalLegacy();
-  } else {
-    HandleClockInternalGrids();
-  }
-
-  adc.Scan();
-  UpdateClockOut();
-  UpdateLeds();
-}
-
-// Pin Change Interrupt for Pause CV input (Port C, Pin 3)
-ISR(PCINT1_vect) {
-  // read the port and mask with desired pin
-  bool pin_state = (PINC & _BV(PINC3));
-
-  // invert because inverting op-amp input (high CV is low MCU input)
-  bool cv_input = !pin_state;
-  if (cv_input == HIGH) {
-    run_state = STATE_PAUSED;
-  } else if (cv_input == LOW) {
-    run_state = STATE_RUNNING;
-  }
-}
-
-RunningAverage<10> smooth_rate;
-static uint8_t pot_values[8];
-static uint32_t parameter_timeout = 0;
-
-/**
- * @brief ScanPots deals with constantly checking the inputs, both CV and UI.
- * It's called from our main() loop, so it handles things for both the
- * Grids-based system, and the Legacy system.
- */
-void ScanPots() {
-  // This handles switching to the settings menu
-  if (long_press_detected) {
-    if (parameter == PARAMETER_NONE) {
-      // Freeze pot values, enter settings mode
-      for (uint8_t i = 1; i < 3; ++i) {
-        pot_values[i] = adc.Read8(i);
-      }
-      parameter = PARAMETER_TRANSITION;
-      LedDance();
-      parameter = PARAMETER_WAITING;
-    } else { // Save the settings, exit settings menu to main functionality
-      parameter = PARAMETER_TRANSITION;
-      LedDance();
-      clock.SaveSettings();
-      parameter = PARAMETER_NONE;
-
-      // if the pause function is disabled, make sure we're running
-      if (clock.tap_tempo() && !clock.legacy_mode()) {
-        run_state = STATE_RUNNING;
-      }
-    }
-    long_press_detected = false;
-  }
-
-  if (parameter == PARAMETER_NONE) {                // In normal operation...
-    uint8_t pot_val = adc.Read8(ADC_CHANNEL_TEMPO); // Fetch the pot value
-    pot_val = smooth_rate.push_and_get(pot_val);    // Smooth it out
-    uint8_t cv_val = ~adc.Read8(ADC_CHANNEL_TEMPO_CV);
-
-    // Legacy Mode update
-    uint16_t combo_val = pot_val + cv_val; // plain add the values
-    // clamp to maximum index
-    if (combo_val > LUT_RES_LEGACY_TIMER_SCALER_SIZE) {
-      combo_val = LUT_RES_LEGACY_TIMER_SCALER_SIZE;
-    }
-    // Tap Tempo mode setting doubles as lin/log setting for legacy mode
-    if (clock.tap_tempo()) {
-      legacy_comparator = pgm_read_dword(lut_res_legacy_timer_log + pot_val);
-    } else {
-      legacy_comparator = pgm_read_dword(lut_res_legacy_timer_lin + pot_val);
-    }
-
-    // Grids BPM update
-    uint8_t pot_bpm = U8U8MulShift8(pot_val, 220) + 20;
-    uint16_t bpm = pot_bpm + U8U8MulShift8(cv_val, 240);
-    if (bpm != clock.bpm() && !clock.locked()) {
-      clock.Update(bpm, clock.clock_resolution());
-    }
-
-    // Fetch the switch value
-    bool mode = adc.Read8(ADC_CHANNEL_SELECTOR) & 0x80;
-    if (mode) { // switch to left
-      speed_mode = MODE_SLOW;
-      TCCR2B = _BV(CS21) | _BV(CS20); // legacy mode clk/32 prescaler
-    } else {
-      speed_mode = MODE_FAST;
-      TCCR2B = _BV(CS21); // legacy mode clk/8 prescaler
-    }
-
-  } else { // In Settings menu, editing parameters...
-    // There's only two inputs we care about,
-    for (uint8_t i = ADC_CHANNEL_TEMPO; i <= ADC_CHANNEL_SELECTOR; ++i) {
-      int16_t value = adc.Read8(i);
-      int16_t delta = value - pot_values[i]; // calculate the change
-      if (delta < 0) {
-        delta = -delta; // absolute value of delta
-      }
-
-      if (delta > 32) {
-        // value is from Read8, guranteed uint8_t
-        pot_values[i] = static_cast<uint8_t>(value);
-
-        switch (i) {
-        // Editing the clock resolution/mode
-        case ADC_CHANNEL_TEMPO: {
-          parameter = PARAMETER_CLOCK_RESOLUTION;
-
-          // take only the two most significant bits of the value
-          uint8_t truncated_value = (value >> 6);
-          if (truncated_value == 0x00) { // Enable legacy mode
-            clock.set_legacy_mode(true);
-            TIMSK2 = _BV(OCIE2A); // enable our Timer 2 interrupt
-          } else {
-            TIMSK2 = 0x00; // clear Timer 2 interrupt enable
-            clock.set_legacy_mode(false);
-            // clock resolutions are 0 indexed and don't include the legacy mode
-            clock.set_clock_resolution(truncated_value - 1);
-            clock.Update(clock.bpm(), clock.clock_resolution());
-          }
-          break;
-        }
-
-        // Editing the Tap Tempo settings
-        case ADC_CHANNEL_SELECTOR:
-          parameter = PARAMETER_TAP_TEMPO;
-          clock.set_tap_tempo(!(value & 0x80));
-          if (!clock.tap_tempo()) {
-            clock.Unlock();
-          }
-          break;
-        }
-        parameter_timeout = 400000;
-      }
-    }
-    if (parameter != PARAMETER_WAITING) {
-      parameter_timeout -= 1;
-      if (parameter_timeout <= 0) {
-        parameter = PARAMETER_WAITING;
-      }
-    }
-  }
-}
-
-/**
- * @brief Initialize the microcontroller.
- * This handles setup of all the required pins, timers, and interrupts
- */
-void Init() {
-  sei();
-  UCSR0B = 0;
-
-  clockOut.set_mode(DIGITAL_OUTPUT);
-  clock.Init();
-
-  button.Init();
-  button.DisablePullUpResistor();
-
-  adc.Init();
-  adc.set_num_inputs(ADC_CHANNEL_LAST);
-  Adc::set_reference(ADC_DEFAULT);
-  Adc::set_alignment(ADC_LEFT_ALIGNED);
-
-  // Pin Change Interrupt for Pause CV (port C, pin 3)
-  PCICR |= _BV(PCIE1);
-  PCMSK1 |= _BV(PCINT11);
-
-  // Setup LED outputs
-  DDRD |= _BV(PD6) | _BV(PD5);
-  OCR0A = 0;
-  OCR0B = 0;
-  TCCR0A = _BV(COM0A1) | _BV(COM0B1) | _BV(WGM01) |
-           _BV(WGM00); // Non-Inverting Fast PWM mode 3 using OCR A & B unit
-  TCCR0B = _BV(CS00);  // No-Prescalar
-
-  // Setup GRIDS MODE timer
-  TCCR1A = 0x00;
-  TCCR1B = _BV(WGM12) // Clear Timer on Compare Match (CTC), TOP is set by OCR1A
-           | _BV(CS11) | _BV(CS10); // Set the prescaler to clk/64
-  OCR1A = kUpdatePeriod - 1;        // every 12.8ms
-  TIMSK1 = _BV(OCIE1A);             // Output Compare Match A Interrupt Enable
-
-  // Setup internal clock timer (LEGACY)
-  TCCR2A = _BV(WGM21);   // CTC, TOP is set by OCR2A
-  TCCR2B = _BV(CS21);    // divide clock source by 8
-  OCR2A = kTimer2Period; // update every interval
-
-  // We'll only enable the interrupt when we switch to
-  // legacy mode to save clock cycles in Grids mode.
-  if (clock.legacy_mode()) {
-    TIMSK2 = _BV(OCIE2A); // enable our Timer 2 interrupt
-  }
-}
-
-/**
- * @brief The main loop
- * Very simple main loop, most of the major timekeeping and output updating is
- * done via interrupts ()
- */
-int main(void) {
-  ResetWatchdog();
-  Init();
-  clock.Update(clock.bpm(), clock.clock_resolution());
-  while (1) {
-    // Use any spare cycles to read the CVs and update the potentiometers
-    ScanPots();
-  }
-}
\ No newline at end of file
+// Copyright 2012 Emilie Gillet, 2023 Katherine Whitlock
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//         Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bench.h"
+#include "clock.h"
+#include "double_buffer.h"
+#include "edge_scheduler.h"
+#include "eeprom_writer.h"
+#include "event_queue.h"
+#include "filters.h"
+#include "firmware.h"
+#include "hal.h"
+#include "hardware_config.h"
+#include "led.h"
+#include "legacy_period.h"
+#include "pause.h"
+#include "profiler.h"
+#include "recorder.h"
+#include "resources.h"
+#include "scheduler.h"
+#include "settings_journal.h"
+#include "sync_pll.h"
+#include "tap_tempo.h"
+#include "timebase.h"
+
+#ifdef __AVR__
+#include "avrlib/boot.h"
+#include "avrlib/watchdog_timer.h"
+
+using namespace avrlib;
+#endif
+using namespace clkr;
+
+hal::ClockOut clockOut;
+#ifdef CLKR_RECORDER
+// Every reading the firmware takes goes into the input log
+RecordedButton<hal::Button> button;
+RecordedAdc<hal::Adc> adc;
+#else
+hal::Button button;
+hal::Adc adc;
+#endif
+
+enum Parameter {
+  PARAMETER_NONE,       // In main mode
+  PARAMETER_TRANSITION, // Entering/Leaving settings editor
+  PARAMETER_WAITING,    // In settings editor mode
+  PARAMETER_CLOCK_RESOLUTION,
+  PARAMETER_TAP_TEMPO, // or pause
+  PARAMETER_RESTART_MODE,
+};
+
+enum SpeedMode {
+  MODE_FAST, // 0v corresponds to right position, and 5v to left position
+  MODE_SLOW, // ordered like this for ease of translation
+};
+
+volatile bool legacy_clock = LOW;
+
+volatile Parameter parameter = PARAMETER_NONE;
+volatile SpeedMode speed_mode = MODE_FAST;
+
+// Button events for the main loop, timestamped by the Timebase
+EventQueue<Event, 8> events;
+
+// Legacy half period, in Timer1 counts (CPU cycles). The lookup tables
+// count in clk/8 steps, and the longest (1.2s, or 4.9s in SLOW mode) is far
+// wider than the 16-bit timer, so the EdgeScheduler extends it in software
+// and we only get interrupted once per timer wrap on the way to each edge.
+DoubleBuffer<uint32_t> legacy_interval;
+
+// Output level of the Grids clock, before the pause gates it
+volatile bool grids_clock = LOW;
+
+uint8_t led_pattern[2] = {0, 0};
+
+/* Update the LEDS to reflect the current state of the system. */
+inline void UpdateLeds() {
+  // Settings transitions and waiting for an edit have their own patterns
+  if (LedSequencer::playing()) {
+    LedSequencer::Step();
+    return;
+  }
+
+  uint8_t clock_pwm = led_pattern[LED_CLOCK];
+  uint8_t pause_pwm = led_pattern[LED_PAUSE];
+
+  // We're not editing any parameters...
+  if (parameter == PARAMETER_NONE) {
+    clock_pwm = 0x00; // led_pattern[LED_CLOCK];
+    pause_pwm = 0x00; // led_pattern[LED_PAUSE];
+
+    // Clock LED
+    if (clock.legacy_mode()) {
+      clock_pwm = legacy_clock ? BRIGHTNESS_FULL : BRIGHTNESS_NONE;
+    } else { // Grids Mode
+      if (clock.on_first_half()) {
+        clock_pwm = BRIGHTNESS_FULL;
+
+        // If the clock is locked, (such as by tap tempo or sync),
+        // also flash the pause light at the same time to
+        // give a "synchronized" appearance.
+        if (clock.locked() || (kSyncInput && SyncPll::locked())) {
+          pause_pwm = BRIGHTNESS_FULL;
+        }
+      }
+    }
+
+    // If we're paused, display such
+    if (Pause::paused()) {
+      pause_pwm = BRIGHTNESS_FULL;
+    }
+
+    LedSetBrightness(LED_CLOCK, clock_pwm);
+    LedSetBrightness(LED_PAUSE, pause_pwm);
+    led_pattern[LED_CLOCK] = clock_pwm;
+    led_pattern[LED_PAUSE] = pause_pwm;
+  } else if (parameter >= PARAMETER_CLOCK_RESOLUTION) { // EDITing a parameter
+    clock_pwm = BRIGHTNESS_NONE;
+    pause_pwm = BRIGHTNESS_NONE;
+    switch (parameter) {
+    case PARAMETER_CLOCK_RESOLUTION: {
+      if (!clock.legacy_mode()) { // legacy mode is just all dark
+        auto clock_resolution = clock.clock_resolution();
+        if (clock_resolution == CLOCK_RESOLUTION_4_PPQN) {
+          clock_pwm = BRIGHTNESS_FULL;
+        } else if (clock_resolution == CLOCK_RESOLUTION_8_PPQN) {
+          pause_pwm = BRIGHTNESS_FULL;
+        } else if (clock_resolution == CLOCK_RESOLUTION_24_PPQN) {
+          clock_pwm = BRIGHTNESS_FULL;
+          pause_pwm = BRIGHTNESS_FULL;
+        } else if (clock_resolution == CLOCK_RESOLUTION_48_PPQN) {
+          clock_pwm = BRIGHTNESS_FULL;
+          pause_pwm = BRIGHTNESS_HALF;
+        } else if (clock_resolution == CLOCK_RESOLUTION_96_PPQN) {
+          clock_pwm = BRIGHTNESS_HALF;
+          pause_pwm = BRIGHTNESS_FULL;
+        }
+      }
+      break;
+    }
+
+    case PARAMETER_TAP_TEMPO:
+      if (clock.legacy_mode()) {
+        // Linear, log or exp: top, bottom or both
+        LegacyCurve curve = clock.legacy_curve();
+        if (curve != LEGACY_CURVE_LOG) {
+          clock_pwm = BRIGHTNESS_FULL;
+        }
+        if (curve != LEGACY_CURVE_LINEAR) {
+          pause_pwm = BRIGHTNESS_FULL;
+        }
+      } else if (clock.tap_tempo()) {
+        pause_pwm = BRIGHTNESS_FULL;
+      } else {
+        clock_pwm = BRIGHTNESS_FULL;
+      }
+      break;
+
+    case PARAMETER_RESTART_MODE:
+      // Phase reset, immediate, pulse or beat: both, top, bottom or both
+      // half lit
+      switch (clock.restart_mode()) {
+      case RESTART_IMMEDIATE:
+        clock_pwm = BRIGHTNESS_FULL;
+        break;
+      case RESTART_PULSE:
+        pause_pwm = BRIGHTNESS_FULL;
+        break;
+      case RESTART_BEAT:
+        clock_pwm = BRIGHTNESS_HALF;
+        pause_pwm = BRIGHTNESS_HALF;
+        break;
+      default:
+        clock_pwm = BRIGHTNESS_FULL;
+        pause_pwm = BRIGHTNESS_FULL;
+        break;
+      }
+      break;
+
+    default:
+      break;
+    }
+    LedSetBrightness(LED_CLOCK, clock_pwm);
+    LedSetBrightness(LED_PAUSE, pause_pwm);
+  }
+}
+
+// The clock's share of the interrupts, specialized for every mode the
+// settings can put it in, with the resolution and range switch folded in at
+// compile time. The interrupts call whichever SelectClockHandlers() last
+// picked, rather than working out the mode on every tick and edge.
+typedef void (*ClockHandler)();
+
+// Grids Mode, polled. Called every tick from TIMER1_COMPA_vect, it pushes
+// the phase accumulator forwards and follows it on the output.
+template <ClockResolution resolution, SpeedMode speed>
+void HandleGridsTick() {
+  BENCH_BEGIN(BENCH_CLOCK_GRIDS);
+  clock.Tick();
+  clock.Wrap(0); // No clock swing
+  if (clock.raising_edge()) {
+    clock.TickClock(PulseLength(resolution));
+  }
+  BENCH_END(BENCH_CLOCK_GRIDS);
+
+  BENCH_BEGIN(BENCH_CLOCK_OUT);
+  if (speed == MODE_FAST) {
+    // In the FAST mode, past_falling_edge and new_pulse
+    // determine the bounds of our square wave output
+    if (clock.past_falling_edge()) {
+      grids_clock = LOW;
+    } else if (clock.new_pulse()) {
+      grids_clock = HIGH;
+    }
+  } else {
+    // But SLOW mode just follows the LED (50% duty cycle)
+    grids_clock = clock.on_first_half();
+  }
+
+  // Don't let the Pause CV in between the gate and the pin
+  hal::InterruptLock lock;
+  clockOut.set_value(Pause::Gate(grids_clock, clock.on_beat()));
+  BENCH_END(BENCH_CLOCK_OUT);
+}
+
+// Legacy edges all come from TIMER1_COMPB_vect
+void HandleLegacyTick() {}
+
+// Set up the Grids edge num_half_pulses halves of a kPulsesPerBeat pulse
+// after the one just output
+inline void ScheduleGridsEdge(uint8_t half_pulses) {
+  if (kSyncInput && SyncPll::active()) {
+    EdgeScheduler::Next(SyncPll::NextEdgeInterval(
+        half_pulses, EdgeScheduler::kMinimumInterval));
+  } else {
+    EdgeScheduler::Next(clock.NextEdgeInterval(half_pulses));
+  }
+}
+
+// Grids Mode, scheduled. Called on each edge from TIMER1_COMPB_vect, FAST
+// mode toggles every half pulse at the current resolution, SLOW mode every
+// half beat. The output is set before the next edge is worked out, to keep
+// it as close to the compare match as it can be.
+template <ClockResolution resolution> void HandleGridsEdgeFast() {
+  BENCH_BEGIN(BENCH_CLOCK_GRIDS);
+  grids_clock = !grids_clock;
+  if (grids_clock) {
+    clock.TickClock(PulseLength(resolution));
+  }
+  BENCH_END(BENCH_CLOCK_GRIDS);
+
+  BENCH_BEGIN(BENCH_CLOCK_OUT);
+  clockOut.set_value(Pause::Gate(grids_clock, clock.on_beat()));
+  BENCH_END(BENCH_CLOCK_OUT);
+
+  BENCH_BEGIN(BENCH_NEXT_EDGE);
+  ScheduleGridsEdge(PulseLength(resolution));
+  BENCH_END(BENCH_NEXT_EDGE);
+}
+
+void HandleGridsEdgeSlow() {
+  BENCH_BEGIN(BENCH_CLOCK_GRIDS);
+  clock.TickClock(kPulsesPerBeat / 2);
+  grids_clock = clock.on_first_half();
+  BENCH_END(BENCH_CLOCK_GRIDS);
+
+  BENCH_BEGIN(BENCH_CLOCK_OUT);
+  clockOut.set_value(Pause::Gate(grids_clock, clock.on_beat()));
+  BENCH_END(BENCH_CLOCK_OUT);
+
+  BENCH_BEGIN(BENCH_NEXT_EDGE);
+  ScheduleGridsEdge(kPulsesPerBeat);
+  BENCH_END(BENCH_NEXT_EDGE);
+}
+
+// Legacy Mode. No differentiation between FAST and SLOW here, it's handled
+// by the legacy interval computed in ScanPots(). Every period counts as a
+// beat.
+void HandleLegacyEdge() {
+  BENCH_BEGIN(BENCH_CLOCK_OUT);
+  legacy_clock = !legacy_clock;
+  clockOut.set_value(Pause::Gate(legacy_clock, true));
+  BENCH_END(BENCH_CLOCK_OUT);
+
+  BENCH_BEGIN(BENCH_NEXT_EDGE);
+  EdgeScheduler::Next(legacy_interval.Read());
+  BENCH_END(BENCH_NEXT_EDGE);
+}
+
+template <SpeedMode speed>
+ClockHandler GridsTickHandler(ClockResolution resolution) {
+  switch (resolution) {
+  case CLOCK_RESOLUTION_4_PPQN:
+    return &HandleGridsTick<CLOCK_RESOLUTION_4_PPQN, speed>;
+  case CLOCK_RESOLUTION_8_PPQN:
+    return &HandleGridsTick<CLOCK_RESOLUTION_8_PPQN, speed>;
+  case CLOCK_RESOLUTION_48_PPQN:
+    return &HandleGridsTick<CLOCK_RESOLUTION_48_PPQN, speed>;
+  case CLOCK_RESOLUTION_96_PPQN:
+    return &HandleGridsTick<CLOCK_RESOLUTION_96_PPQN, speed>;
+  default:
+    return &HandleGridsTick<CLOCK_RESOLUTION_24_PPQN, speed>;
+  }
+}
+
+ClockHandler GridsEdgeHandler(ClockResolution resolution) {
+  switch (resolution) {
+  case CLOCK_RESOLUTION_4_PPQN:
+    return &HandleGridsEdgeFast<CLOCK_RESOLUTION_4_PPQN>;
+  case CLOCK_RESOLUTION_8_PPQN:
+    return &HandleGridsEdgeFast<CLOCK_RESOLUTION_8_PPQN>;
+  case CLOCK_RESOLUTION_48_PPQN:
+    return &HandleGridsEdgeFast<CLOCK_RESOLUTION_48_PPQN>;
+  case CLOCK_RESOLUTION_96_PPQN:
+    return &HandleGridsEdgeFast<CLOCK_RESOLUTION_96_PPQN>;
+  default:
+    return &HandleGridsEdgeFast<CLOCK_RESOLUTION_24_PPQN>;
+  }
+}
+
+// What the tick and edge interrupts call. Only ever written with interrupts
+// disabled, by SelectClockHandlers().
+ClockHandler volatile tick_handler = &HandleLegacyTick;
+ClockHandler volatile edge_handler = &HandleLegacyEdge;
+
+/* Point the interrupts at the handlers for the current mode, resolution
+   and range, from the main loop whenever any of them might have changed */
+void SelectClockHandlers() {
+  ClockHandler tick = &HandleLegacyTick;
+  ClockHandler edge = &HandleLegacyEdge;
+  if (!clock.legacy_mode()) {
+    ClockResolution resolution = clock.clock_resolution();
+    if (speed_mode == MODE_SLOW) {
+      tick = GridsTickHandler<MODE_SLOW>(resolution);
+      edge = &HandleGridsEdgeSlow;
+    } else {
+      tick = GridsTickHandler<MODE_FAST>(resolution);
+      edge = GridsEdgeHandler(resolution);
+    }
+  }
+  if (tick != tick_handler || edge != edge_handler) {
+    hal::InterruptLock lock;
+    tick_handler = tick;
+    edge_handler = edge;
+  }
+}
+
+// Restart the clock from the top of a pulse, from the main loop
+inline void ResetClock() {
+  hal::InterruptLock lock;
+  clock.Reset();
+  if (kScheduledEdges && !clock.legacy_mode()) {
+    grids_clock = LOW;
+    EdgeScheduler::Start(EdgeScheduler::kMinimumInterval);
+  }
+}
+
+// Restart the clock from the top of the beat as a pause ends, with the
+// first rising edge kMinimumInterval away
+inline void RestartClock() {
+  hal::InterruptLock lock;
+  clock.Restart();
+  grids_clock = LOW;
+  legacy_clock = LOW;
+  if (kScheduledEdges || clock.legacy_mode()) {
+    EdgeScheduler::Start(EdgeScheduler::kMinimumInterval);
+  }
+}
+
+// Mute the output, from the Pause CV or button, with interrupts disabled
+inline void HoldOutput(uint32_t time) {
+  clockOut.set_value(LOW);
+  Pause::Hold(time);
+}
+
+// Pick the output up again as a pause ends, with interrupts disabled
+inline void ReleaseOutput(uint32_t time) {
+  switch (Pause::Release(time, clock.restart_mode())) {
+  case PAUSE_ACTION_FOLLOW:
+    clockOut.set_value(clock.legacy_mode() ? legacy_clock : grids_clock);
+    break;
+  case PAUSE_ACTION_RESTART:
+    RestartClock();
+    break;
+  default:
+    break;
+  }
+}
+
+enum SwitchState {
+  SWITCH_STATE_JUST_PRESSED = 0x01,
+  SWITCH_STATE_PRESSED = 0xff,
+  SWITCH_STATE_JUST_RELEASED = 0xfe,
+  SWITCH_STATE_RELEASED = 0x00
+};
+
+// Queue an event for the main loop. The tick interrupt runs with interrupts
+// enabled, so keep its pushes from racing the pin change interrupt's.
+inline void PostEvent(uint8_t type, uint8_t value) {
+  hal::InterruptLock lock;
+  Event event = {type, value, Timebase::now()};
+  events.Push(event);
+}
+
+// Holding the button this long opens or closes the settings menu
+const uint32_t kLongPress = Timebase::FromMillis(1250);
+
+inline void HandleTapButton() {
+  static uint8_t switch_state = 0x00; // default state is LOW
+  static uint32_t pressed_at = 0;
+  static bool long_press = false;
+
+  switch_state = switch_state << 1;
+  if (button.Read()) {
+    switch_state |= 1;
+  }
+
+  if (switch_state == SWITCH_STATE_JUST_PRESSED) {
+    PostEvent(EVENT_BUTTON_PRESSED, 0);
+    pressed_at = Timebase::now();
+    long_press = false;
+  } else if (switch_state == SWITCH_STATE_JUST_RELEASED) {
+    PostEvent(EVENT_BUTTON_RELEASED, 0);
+  } else if (switch_state == SWITCH_STATE_PRESSED && !long_press &&
+             Timebase::now() - pressed_at >= kLongPress) {
+    PostEvent(EVENT_LONG_PRESS, 0);
+    long_press = true;
+  }
+}
+
+// Interrupt for Timer1 (GRIDS MODE)
+ISR(TIMER1_COMPA_vect) {
+  static uint8_t switch_debounce_prescaler;
+  PROFILE_ISR_DUE(PROFILE_TICK, hal::TickTimer::compare());
+
+  // Set up the next tick, then let the edge and pin change
+  // interrupts preempt the rest of this one.
+  hal::TickTimer::Advance(kUpdatePeriod);
+  Timebase::Tick(kUpdatePeriod);
+  if (kSyncInput) {
+    SyncPll::Tick();
+  }
+  hal::EnableInterrupts();
+
+  ++switch_debounce_prescaler;
+  if (switch_debounce_prescaler >= 10) {
+    // Debounce RESET/TAP switch and perform switch action.
+    BENCH_BEGIN(BENCH_TAP_BUTTON);
+    HandleTapButton();
+    BENCH_END(BENCH_TAP_BUTTON);
+    switch_debounce_prescaler = 0;
+  }
+
+  if (!kScheduledEdges) {
+    tick_handler();
+  }
+}
+
+// Interrupt for Timer1 compare B, right on the edge
+ISR(TIMER1_COMPB_vect) {
+  PROFILE_ISR_DUE(PROFILE_EDGE, EdgeScheduler::compare());
+  if (!EdgeScheduler::Expired()) {
+    return; // a timer wrap on the way
+  }
+  edge_handler();
+}
+
+// Pin Change Interrupt for Pause CV input (Port C, Pin 3)
+ISR(PCINT1_vect) {
+  PROFILE_ISR(PROFILE_PAUSE_CV);
+  bool cv_input = hal::PauseCv::Read();
+  if (kSyncInput) {
+    // Sync input instead, timestamp rising edges for the PLL
+    uint32_t time = Timebase::now();
+    if (cv_input == HIGH && !clock.legacy_mode()) {
+      BENCH_BEGIN(BENCH_SYNC);
+      if (SyncPll::Edge(time)) {
+        // Acquired, restart the output on this beat
+        clock.Restart();
+        grids_clock = LOW;
+        EdgeScheduler::Start(EdgeScheduler::kMinimumInterval);
+        SyncPll::Align(EdgeScheduler::compare());
+      }
+      BENCH_END(BENCH_SYNC);
+    }
+    RECORD_PAUSE_CV(cv_input, time);
+    return;
+  }
+
+  uint32_t time;
+  if (cv_input == HIGH) {
+    // Gate off first, the timestamp can wait
+    clockOut.set_value(LOW);
+    time = Timebase::now();
+    Pause::Hold(time);
+  } else {
+    time = Timebase::now();
+    ReleaseOutput(time);
+  }
+  // Logged at the time the pause engine got, once it is done
+  RECORD_PAUSE_CV(cv_input, time);
+}
+
+// EEPROM ready, write out the next queued settings byte
+ISR(EE_READY_vect) { EepromWriter::Ready(); }
+
+// Follows a turn within a few scans, holds still against a couple of LSBs of
+// noise. See src/native/filter_bench.cpp for how it compares.
+AdaptiveFilter<5, 1, 0x200, 0x20> smooth_rate;
+static uint8_t pot_values[8];
+
+// Back to waiting for an edit this long after the last one
+const uint32_t kParameterTimeout = Timebase::FromMillis(4000);
+static uint32_t last_edit = 0;
+
+// Where the settings menu goes once the LEDs have danced
+static Parameter after_transition = PARAMETER_NONE;
+
+static void WaitForEdit() {
+  parameter = PARAMETER_WAITING;
+  LedSequencer::Play(kLedBreathe);
+}
+
+/* Act on a button event, from the main loop */
+void HandleEvent(const Event &event) {
+  // Whether the press being released was a long one
+  static bool long_press = false;
+
+  switch (event.type) {
+  case EVENT_BUTTON_PRESSED:
+    long_press = false;
+    if (parameter != PARAMETER_NONE) {
+      break;
+    }
+    if (!clock.tap_tempo() || clock.legacy_mode()) {
+      // Act as a pause button
+      hal::InterruptLock lock;
+      if (Pause::paused()) {
+        ReleaseOutput(event.time);
+      } else {
+        HoldOutput(event.time);
+      }
+    } else {
+      // Tap Tempo system, start the beat on the tap
+      uint16_t tempo;
+      switch (TapTempo::Tap(event.time, &tempo)) {
+      case TAP_TEMPO_UPDATE:
+        clock.Update(tempo, clock.clock_resolution());
+        ResetClock();
+        clock.Lock();
+        clock.SaveSettings();
+        break;
+      case TAP_TEMPO_UNLOCK:
+        clock.Unlock();
+        clock.SaveSettings();
+        break;
+      default:
+        break;
+      }
+    }
+    break;
+
+  // In the settings menu, a short press steps on to the next restart mode
+  case EVENT_BUTTON_RELEASED: {
+    if (parameter >= PARAMETER_WAITING && !long_press) {
+      parameter = PARAMETER_RESTART_MODE;
+      LedSequencer::Stop();
+      uint8_t mode = clock.restart_mode() + 1;
+      clock.set_restart_mode(mode < RESTART_LAST
+                                 ? static_cast<RestartMode>(mode)
+                                 : RESTART_PHASE_RESET);
+      last_edit = Timebase::now();
+    }
+    break;
+  }
+
+  // This handles switching to the settings menu
+  case EVENT_LONG_PRESS:
+    long_press = true;
+    if (parameter == PARAMETER_NONE) {
+      // Freeze pot values, enter settings mode
+      for (uint8_t i = 1; i < 3; ++i) {
+        pot_values[i] = adc.Read8(i);
+      }
+      parameter = PARAMETER_TRANSITION;
+      after_transition = PARAMETER_WAITING;
+      LedSequencer::Play(kLedDance);
+    } else if (parameter != PARAMETER_TRANSITION) {
+      // Save the settings, exit settings menu to main functionality
+      parameter = PARAMETER_TRANSITION;
+      after_transition = PARAMETER_NONE;
+      LedSequencer::Play(kLedDance);
+      clock.SaveSettings();
+
+      // if the pause function is disabled, make sure we're running
+      if (clock.tap_tempo() && !clock.legacy_mode()) {
+        hal::InterruptLock lock;
+        ReleaseOutput(event.time);
+      }
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/* Catch up on everything the interrupts have seen, in order */
+void HandleEvents() {
+  Event event;
+  while (events.Pop(&event)) {
+    HandleEvent(event);
+  }
+
+  // The settings menu moves on once the LEDs are done dancing
+  if (parameter == PARAMETER_TRANSITION && !LedSequencer::playing()) {
+    if (after_transition == PARAMETER_WAITING) {
+      WaitForEdit();
+    } else {
+      parameter = after_transition;
+    }
+  }
+}
+
+/**
+ * @brief ScanPots deals with checking the inputs, both CV and UI.
+ * It's a main loop task, so it handles things for both the
+ * Grids-based system, and the Legacy system.
+ */
+void ScanPots() {
+  if (parameter == PARAMETER_TRANSITION) {
+    return;
+  }
+
+  if (parameter == PARAMETER_NONE) {                // In normal operation...
+    // Oversampled, 12 significant bits, left aligned
+    uint16_t pot_val16 =
+        smooth_rate.push_and_get(adc.Read16(ADC_CHANNEL_TEMPO));
+    uint16_t cv_val16 = ~adc.Read16(ADC_CHANNEL_TEMPO_CV);
+
+    // Legacy Mode update, the CV adds on to the pot
+    uint32_t interval = LegacyPeriod::Compute(
+        clock.legacy_curve(), LegacyPeriod::Position(pot_val16) +
+                                  LegacyPeriod::Position(cv_val16));
+
+    // Grids tempo update, 20-240 BPM from the pot plus up to 240 from CV,
+    // in 1/16 BPM steps
+    uint16_t tempo = BpmToTempo(20) +
+                     ((pot_val16 * (220UL << kTempoFractionalBits)) >> 16) +
+                     ((cv_val16 * (240UL << kTempoFractionalBits)) >> 16);
+    bool synced = kSyncInput && SyncPll::active();
+    if (synced) {
+      tempo = SyncPll::tempo();
+    }
+    if (tempo != clock.tempo() && (synced || !clock.locked())) {
+      clock.Update(tempo, clock.clock_resolution());
+    }
+
+    // Fetch the switch value
+    bool mode = adc.Read8(ADC_CHANNEL_SELECTOR) & 0x80;
+    if (mode) { // switch to left
+      speed_mode = MODE_SLOW;
+      interval <<= 5; // clk/32 steps, legacy periods are 4 times as long
+    } else {
+      speed_mode = MODE_FAST;
+      interval <<= 3; // clk/8 steps
+    }
+    if (interval != legacy_interval.Read()) {
+      legacy_interval.Write(interval);
+    }
+    SelectClockHandlers();
+    if (!EdgeScheduler::running()) {
+      if (clock.legacy_mode()) {
+        EdgeScheduler::Start(interval);
+      } else if (kScheduledEdges) {
+        EdgeScheduler::Start(EdgeScheduler::kMinimumInterval);
+      }
+    }
+
+  } else { // In Settings menu, editing parameters...
+    // There's only two inputs we care about,
+    for (uint8_t i = ADC_CHANNEL_TEMPO; i <= ADC_CHANNEL_SELECTOR; ++i) {
+      int16_t value = adc.Read8(i);
+      int16_t delta = value - pot_values[i]; // calculate the change
+      if (delta < 0) {
+        delta = -delta; // absolute value of delta
+      }
+
+      if (delta > 32) {
+        // value is from Read8, guranteed uint8_t
+        pot_values[i] = static_cast<uint8_t>(value);
+
+        switch (i) {
+        // Editing the clock resolution/mode
+        case ADC_CHANNEL_TEMPO: {
+          parameter = PARAMETER_CLOCK_RESOLUTION;
+          LedSequencer::Stop();
+
+          // Legacy mode, then each resolution, in equal parts of the range
+          uint8_t truncated_value = (value * (CLOCK_RESOLUTION_LAST + 1)) >> 8;
+          if (truncated_value == 0x00) { // Enable legacy mode
+            clock.set_legacy_mode(true);
+          } else {
+            if (!kScheduledEdges) {
+              EdgeScheduler::Stop();
+            }
+            clock.set_legacy_mode(false);
+            // clock resolutions are 0 indexed and don't include the legacy mode
+            clock.set_clock_resolution(truncated_value - 1);
+            clock.Update(clock.tempo(), clock.clock_resolution());
+          }
+          SelectClockHandlers();
+          break;
+        }
+
+        // Editing the Tap Tempo settings, or in legacy mode, stepping on
+        // to the next response curve with each flip
+        case ADC_CHANNEL_SELECTOR:
+          parameter = PARAMETER_TAP_TEMPO;
+          LedSequencer::Stop();
+          if (clock.legacy_mode()) {
+            uint8_t curve = clock.legacy_curve() + 1;
+            clock.set_legacy_curve(curve < LEGACY_CURVE_LAST
+                                       ? static_cast<LegacyCurve>(curve)
+                                       : LEGACY_CURVE_LINEAR);
+            break;
+          }
+          clock.set_tap_tempo(!(value & 0x80));
+          if (!clock.tap_tempo()) {
+            clock.Unlock();
+          }
+          break;
+        }
+        last_edit = Timebase::now();
+      }
+    }
+  }
+}
+
+/* Give up on an edit that has gone quiet */
+void CheckParameterTimeout() {
+  if (parameter >= PARAMETER_CLOCK_RESOLUTION &&
+      Timebase::now() - last_edit >= kParameterTimeout) {
+    WaitForEdit();
+  }
+}
+
+void ScanPotsTask() {
+  BENCH_BEGIN(BENCH_SCAN_POTS);
+  ScanPots();
+  BENCH_END(BENCH_SCAN_POTS);
+}
+
+void UpdateLedsTask() {
+  BENCH_BEGIN(BENCH_LEDS);
+  UpdateLeds();
+  BENCH_END(BENCH_LEDS);
+}
+
+void PollSettings() { SettingsJournal::Poll(); }
+
+#ifdef CLKR_PROFILE
+/* Flipping the range switch with the button held dumps the ISR profile */
+void ProfileTask() {
+  static bool last_range;
+  bool range = adc.Read8(ADC_CHANNEL_SELECTOR) & 0x80;
+  if (range != last_range && button.Read()) {
+    Profiler::Dump();
+  }
+  last_range = range;
+  Profiler::Poll();
+}
+#endif
+
+#ifdef CLKR_RECORDER
+/* Flipping the range switch with the button held dumps the input log. Reads
+   the hardware directly, so the task's own reads stay out of the log. */
+void RecorderTask() {
+  static bool last_range;
+  bool range = hal::Adc::Read8(ADC_CHANNEL_SELECTOR) & 0x80;
+  if (range != last_range && hal::Button::Read()) {
+    Recorder::Dump();
+  }
+  last_range = range;
+  Recorder::Poll();
+}
+#endif
+
+// Everything the main loop does, in milliseconds. Events are handled on
+// every pass, which is every tick as the tick wakes the CPU from sleep.
+const Task tasks[] = {
+    {&HandleEvents, 0},
+    {&ScanPotsTask, 1},
+    {&UpdateLedsTask, LedSequencer::kStepPeriod},
+    {&CheckParameterTimeout, 50},
+    {&PollSettings, 10},
+#ifdef CLKR_PROFILE
+    {&ProfileTask, 50},
+#endif
+#ifdef CLKR_RECORDER
+    {&RecorderTask, 50},
+#endif
+};
+Scheduler<sizeof(tasks) / sizeof(tasks[0])> scheduler(tasks);
+
+void RunTasks() { scheduler.Poll(Timebase::millis()); }
+
+/**
+ * @brief Initialize the microcontroller.
+ * This handles setup of all the required pins, timers, and interrupts
+ */
+void Init() {
+  hal::EnableInterrupts();
+#ifdef __AVR__
+  UCSR0B = 0;
+#endif
+
+  clockOut.Init();
+  clock.Init();
+  SelectClockHandlers();
+
+  button.Init();
+
+  adc.Init(ADC_CHANNEL_LAST);
+
+  // Pin Change Interrupt for Pause CV (port C, pin 3)
+  hal::PauseCv::Init();
+
+  // Setup LED outputs
+  hal::LedPwm::Init();
+
+  // Setup GRIDS MODE timer, every 125us.
+  // Legacy edges are only scheduled once ScanPots() has
+  // worked out their interval, and only in legacy mode.
+  hal::TickTimer::Init(kUpdatePeriod);
+  Timebase::Init(kUpdatePeriod);
+  if (kSyncInput) {
+    SyncPll::Init();
+  }
+#ifdef CLKR_RECORDER
+  Recorder::Start(clock.settings());
+#endif
+}
+
+#ifdef __AVR__
+/**
+ * @brief The main loop
+ * Very simple main loop, most of the major timekeeping and output updating is
+ * done via interrupts ()
+ */
+int main(void) {
+  ResetWatchdog();
+  Init();
+  clock.Update(clock.tempo(), clock.clock_resolution());
+  while (1) {
+    // Do whatever is due, then idle until the next interrupt
+    RunTasks();
+    hal::Sleep();
+  }
+}
+#endif
@@ -0,0 +1,231 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host sweep of the clock output's tempo accuracy and jitter. The firmware
+// boots once and is then taken through every tempo, resolution and range
+// switch setting in turn, locked to the tempo like after a tap, with the
+// simulated timers and main loop running throughout. For each run, once
+// the first few rising edges after the change have gone by:
+//
+//   error   mean output period against the ideal one for the BPM, in ppm.
+//           The ideal is 60 / BPM / PPQN seconds in FAST mode and a whole
+//           beat in SLOW mode.
+//   jitter  peak to peak and RMS spread of the single periods around their
+//           mean, in microseconds
+//   duty    lowest and highest share of each period spent high, in percent
+//
+// A CSV line per run goes to stdout, and a summary of each resolution and
+// mode, with the BPM of its worst case, to stderr.
+//
+// This measures the clock engine's arithmetic only. Interrupts run in no
+// time here and edges land on whole CPU cycles, so 50ns of jitter is one
+// cycle of rounding; the module adds its interrupt latency to that.
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "clock.h"
+#include "clock_accuracy.h"
+#include "firmware.h"
+#include "hal.h"
+#include "hardware_config.h"
+
+using namespace clkr;
+using namespace clkr::hal;
+
+namespace {
+
+const uint16_t kSlowestBpm = 20;
+const uint16_t kFastestBpm = 480;
+
+// Rising edges let through after a change, while the edge already
+// scheduled at the old tempo plays out
+const uint8_t kSettleEdges = 3;
+
+// Every run covers at least this many periods, however slow
+const uint32_t kMinimumPeriods = 32;
+
+struct Edge {
+  uint64_t cycle;
+  uint8_t value;
+};
+
+std::vector<Edge> edges;
+
+void OnClockOut(uint64_t cycle, uint8_t value) {
+  edges.push_back({cycle, value});
+}
+
+struct Result {
+  uint32_t periods;
+  double error_ppm;
+  double jitter_pp_us;
+  double jitter_rms_us;
+  double duty_min;
+  double duty_max;
+};
+
+Result Analyze(double ideal) {
+  Result result = {0, 0.0, 0.0, 0.0, 100.0, 0.0};
+  std::vector<uint64_t> rising;
+  std::vector<double> duty;
+  uint8_t skipped = 0;
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (!edges[i].value) {
+      continue;
+    }
+    if (skipped < kSettleEdges) {
+      ++skipped;
+      continue;
+    }
+    if (!rising.empty()) {
+      double period = static_cast<double>(edges[i].cycle - rising.back());
+      uint64_t falling = 0;
+      for (size_t j = i; j-- > 0 && edges[j].cycle > rising.back();) {
+        if (!edges[j].value) {
+          falling = edges[j].cycle;
+        }
+      }
+      if (falling) {
+        duty.push_back((falling - rising.back()) * 100.0 / period);
+      }
+    }
+    rising.push_back(edges[i].cycle);
+  }
+  if (rising.size() < 2) {
+    return result;
+  }
+
+  result.periods = rising.size() - 1;
+  double mean =
+      static_cast<double>(rising.back() - rising.front()) / result.periods;
+  result.error_ppm = (mean - ideal) / ideal * 1e6;
+
+  double shortest = 1e30, longest = 0.0, sum_squares = 0.0;
+  for (size_t i = 1; i < rising.size(); ++i) {
+    double period = static_cast<double>(rising[i] - rising[i - 1]);
+    shortest = std::min(shortest, period);
+    longest = std::max(longest, period);
+    sum_squares += (period - mean) * (period - mean);
+  }
+  double us = 1e6 / F_CPU;
+  result.jitter_pp_us = (longest - shortest) * us;
+  result.jitter_rms_us = sqrt(sum_squares / result.periods) * us;
+  for (double d : duty) {
+    result.duty_min = std::min(result.duty_min, d);
+    result.duty_max = std::max(result.duty_max, d);
+  }
+  return result;
+}
+
+// Worst cases over one resolution and mode
+struct Summary {
+  double error_ppm;
+  uint16_t error_bpm;
+  double jitter_pp_us;
+  uint16_t jitter_pp_bpm;
+  double jitter_rms_us;
+  uint16_t jitter_rms_bpm;
+  double duty_min;
+  double duty_max;
+};
+
+} // namespace
+
+int ClockAccuracy(double seconds, double max_error_ppm) {
+  SimulatorReset();
+  SimulatorSetAdc(ADC_CHANNEL_TEMPO_CV, 255);
+  simulator.on_clock_out = &OnClockOut;
+  simulator.main_loop = &RunTasks;
+  Init();
+
+  printf("mode,ppqn,bpm,periods,period_error_ppm,jitter_pp_us,"
+         "jitter_rms_us,duty_min,duty_max\n");
+  fprintf(stderr, "%-4s %4s  %-18s %-18s %-18s %s\n", "mode", "ppqn",
+          "error ppm (bpm)", "jitter pp us", "jitter rms us", "duty %");
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t start_cycle = simulator.cycle;
+  double previous = 0.0;
+  bool ok = true;
+  for (uint8_t slow = 0; slow < 2; ++slow) {
+    SimulatorSetAdc(ADC_CHANNEL_SELECTOR, slow ? 0xff : 0x00);
+    for (uint8_t r = 0; r < CLOCK_RESOLUTION_LAST; ++r) {
+      ClockResolution resolution = static_cast<ClockResolution>(r);
+      uint8_t ppqn = ResolutionPpqn(resolution);
+      Summary summary = {0.0, 0, 0.0, 0, 0.0, 0, 100.0, 0.0};
+      for (uint16_t bpm = kSlowestBpm; bpm <= kFastestBpm; ++bpm) {
+        double ideal = F_CPU * 60.0 / bpm / (slow ? 1 : ppqn);
+
+        // As a tap would leave it, so the pot stays out of the way
+        Clock::set_clock_resolution(resolution);
+        Clock::Update(BpmToTempo(bpm), resolution);
+        Clock::Lock();
+
+        edges.clear();
+        double run = std::max(seconds * F_CPU, kMinimumPeriods * ideal);
+        SimulatorRun(static_cast<uint64_t>(run + previous +
+                                           (kSettleEdges + 1) * ideal));
+        previous = ideal;
+
+        Result result = Analyze(ideal);
+        printf("%s,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+               slow ? "slow" : "fast", ppqn, bpm, result.periods,
+               result.error_ppm, result.jitter_pp_us, result.jitter_rms_us,
+               result.duty_min, result.duty_max);
+
+        if (!result.periods || fabs(result.error_ppm) > max_error_ppm) {
+          ok = false;
+        }
+        if (fabs(result.error_ppm) >= fabs(summary.error_ppm)) {
+          summary.error_ppm = result.error_ppm;
+          summary.error_bpm = bpm;
+        }
+        if (result.jitter_pp_us >= summary.jitter_pp_us) {
+          summary.jitter_pp_us = result.jitter_pp_us;
+          summary.jitter_pp_bpm = bpm;
+        }
+        if (result.jitter_rms_us >= summary.jitter_rms_us) {
+          summary.jitter_rms_us = result.jitter_rms_us;
+          summary.jitter_rms_bpm = bpm;
+        }
+        summary.duty_min = std::min(summary.duty_min, result.duty_min);
+        summary.duty_max = std::max(summary.duty_max, result.duty_max);
+      }
+      fprintf(stderr, "%-4s %4u  %+9.3f (%3u)    %9.3f (%3u)    %9.3f (%3u)"
+              "    %.2f-%.2f\n",
+              slow ? "slow" : "fast", ppqn, summary.error_ppm,
+              summary.error_bpm, summary.jitter_pp_us, summary.jitter_pp_bpm,
+              summary.jitter_rms_us, summary.jitter_rms_bpm, summary.duty_min,
+              summary.duty_max);
+    }
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  fprintf(stderr, "simulated %.1f h of output in %.1f s\n",
+          (simulator.cycle - start_cycle) / static_cast<double>(F_CPU) / 3600,
+          elapsed.count());
+  if (!ok) {
+    fprintf(stderr, "FAIL: mean period error above %.1f ppm, or no clock\n",
+            max_error_ppm);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host sweep of the clock output's tempo accuracy and jitter
+
+#pragma once
+
+// Runs the firmware at every whole BPM from 20 to 480, at every clock
+// resolution in FAST and SLOW mode, for at least seconds each. Prints a CSV
+// line per run and a summary per mode. Returns 1 if any run's mean period
+// is off by more than max_error_ppm, or it produced no clock at all.
+int ClockAccuracy(double seconds, double max_error_ppm);
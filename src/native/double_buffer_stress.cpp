@@ -0,0 +1,118 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host stress test of DoubleBuffer against torn reads. The native compiler
+// copies a value in whatever size of stores it likes, so the values here
+// copy themselves a byte at a time, as the AVR does, and run the reader
+// after every byte like an interrupt would. The reader has to see the value
+// published last all the way through the copy, and the new one from the
+// moment Write() returns. Every byte of each value differs from the one
+// before it, so any mix of the two shows.
+//
+// Sizes cover legacy_interval (uint32_t), Clock's ClockRate, and something
+// bigger.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "double_buffer.h"
+#include "double_buffer_stress.h"
+
+using namespace clkr;
+
+namespace {
+
+// A value that hands its reader the floor after every byte it copies
+template <uint8_t size> struct Bytes {
+  Bytes() : bytes() {}
+  Bytes(const Bytes &other) { memcpy(bytes, other.bytes, size); }
+
+  Bytes &operator=(const Bytes &other) {
+    for (uint8_t i = 0; i < size; ++i) {
+      bytes[i] = other.bytes[i];
+      if (interrupt) {
+        interrupt();
+      }
+    }
+    return *this;
+  }
+
+  bool operator==(const Bytes &other) const {
+    return !memcmp(bytes, other.bytes, size);
+  }
+
+  uint8_t bytes[size];
+
+  static void (*interrupt)();
+};
+
+template <uint8_t size> void (*Bytes<size>::interrupt)();
+
+template <uint8_t size> struct Stress {
+  static DoubleBuffer<Bytes<size>> buffer;
+  static Bytes<size> published;
+  static unsigned reads;
+  static bool torn;
+
+  static void Reader() {
+    ++reads;
+    torn = torn || !(buffer.Read() == published);
+  }
+
+  static bool Run(unsigned num_writes) {
+    Bytes<size>::interrupt = &Reader;
+    bool ok = true;
+    for (unsigned write = 0; write < num_writes && ok; ++write) {
+      Bytes<size> next;
+      for (uint8_t i = 0; i < size; ++i) {
+        next.bytes[i] = published.bytes[i] + 1 + rand() % 255;
+      }
+      torn = false;
+      buffer.Write(next);
+      memcpy(published.bytes, next.bytes, size);
+      Reader();
+      if (torn) {
+        printf("%u bytes: write %u was read torn\n", size, write);
+        ok = false;
+      }
+    }
+    Bytes<size>::interrupt = NULL;
+    fprintf(stderr, "%3u bytes: %u writes, %u reads\n", size, num_writes,
+            reads);
+    return ok;
+  }
+};
+
+template <uint8_t size> DoubleBuffer<Bytes<size>> Stress<size>::buffer;
+template <uint8_t size> Bytes<size> Stress<size>::published;
+template <uint8_t size> unsigned Stress<size>::reads;
+template <uint8_t size> bool Stress<size>::torn;
+
+} // namespace
+
+int DoubleBufferStress(unsigned num_writes) {
+  srand(1);
+  bool ok = Stress<sizeof(uint32_t)>::Run(num_writes);
+  ok = Stress<sizeof(ClockRate)>::Run(num_writes) && ok;
+  ok = Stress<16>::Run(num_writes) && ok;
+  if (!ok) {
+    fprintf(stderr, "FAIL: a reader saw a value half written\n");
+  }
+  return ok ? 0 : 1;
+}
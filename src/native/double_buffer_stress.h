@@ -0,0 +1,26 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host stress test of DoubleBuffer against torn reads
+
+#pragma once
+
+// Writes num_writes values of each of a few sizes through a DoubleBuffer,
+// with a reader interrupting the writer at every byte boundary. Returns 1
+// if the reader ever sees anything but the value published last, or the
+// new one once Write() has returned.
+int DoubleBufferStress(unsigned num_writes);
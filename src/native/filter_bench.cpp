@@ -0,0 +1,164 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host benchmark of the pot smoothing filters. Every filter sees the same
+// synthetic 12-bit pot readings, left aligned like hal::Adc::Read16, one per
+// pot scan (every millisecond):
+//
+//   step   pot turned from 1/4 to 3/4 in one go, no noise. Samples until the
+//          output is 90% of the way there, and until it is within 1/256 of
+//          full scale for good.
+//   noise  pot at rest with gaussian noise of 2 LSBs. RMS and peak error of
+//          the output, and how often the resulting Grids tempo changes,
+//          each of which is a Clock::Update.
+//   ramp   pot turned slowly across its whole range with the same noise.
+//          Mean lag behind the pot, in 12-bit LSBs.
+//
+// The speed is host nanoseconds per sample, which only ranks the filters;
+// the ScanPots section of the simavr benchmark has the cycles on the module.
+
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+
+#include "clock.h"
+#include "filter_bench.h"
+#include "filters.h"
+#include "running_average.h"
+
+using namespace clkr;
+
+namespace {
+
+const uint16_t kLsb = 16; // One LSB of the 12-bit reading
+const double kNoise = 2.0 * kLsb;
+const uint32_t kNoiseSamples = 100000;
+const uint32_t kRampSamples = 65536;
+
+// The filter as it was, on the top 8 bits
+struct LegacyAverage {
+  RunningAverage<10> filter;
+  inline uint16_t push_and_get(uint16_t value) {
+    return filter.push_and_get(value >> 8) << 8;
+  }
+  inline uint16_t get() { return filter.get() << 8; }
+};
+
+uint16_t Quantize(double value) {
+  if (value < 0) {
+    return 0;
+  }
+  if (value > 0xfff0) {
+    return 0xfff0;
+  }
+  return static_cast<uint16_t>(value) & 0xfff0;
+}
+
+// Tempo contribution of the pot, as in ScanPots
+uint16_t PotTempo(uint16_t pot) {
+  return (pot * (220UL << kTempoFractionalBits)) >> 16;
+}
+
+template <typename Filter> void Bench(const char *name) {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0.0, kNoise);
+
+  // Step
+  uint32_t rise = 0, settle = 0;
+  {
+    Filter filter;
+    for (int i = 0; i < 256; ++i) {
+      filter.push_and_get(0x4000);
+    }
+    for (uint32_t i = 1; i <= 4096; ++i) {
+      uint16_t out = filter.push_and_get(0xc000);
+      if (!rise && out >= 0x4000 + 0x8000 * 9 / 10) {
+        rise = i;
+      }
+      if (out + 0x100 < 0xc000 || out > 0xc000 + 0x100) {
+        settle = i + 1;
+      }
+    }
+  }
+
+  // Noise at rest
+  double sum_squares = 0, peak = 0;
+  uint32_t updates = 0;
+  {
+    Filter filter;
+    for (int i = 0; i < 4096; ++i) {
+      filter.push_and_get(Quantize(0x8000 + noise(rng)));
+    }
+    uint16_t tempo = PotTempo(filter.get());
+    for (uint32_t i = 0; i < kNoiseSamples; ++i) {
+      uint16_t out = filter.push_and_get(Quantize(0x8000 + noise(rng)));
+      double error = static_cast<double>(out) - 0x8000;
+      sum_squares += error * error;
+      peak = fmax(peak, fabs(error));
+      uint16_t new_tempo = PotTempo(out);
+      updates += new_tempo != tempo;
+      tempo = new_tempo;
+    }
+  }
+
+  // Slow ramp
+  double lag = 0;
+  {
+    Filter filter;
+    for (uint32_t i = 0; i < kRampSamples; ++i) {
+      double pot = 0x1000 + (0xe000 * static_cast<double>(i)) / kRampSamples;
+      uint16_t out = filter.push_and_get(Quantize(pot + noise(rng)));
+      if (i >= kRampSamples / 4) {
+        lag += pot - out;
+      }
+    }
+    lag /= kRampSamples - kRampSamples / 4;
+  }
+
+  // Speed
+  volatile uint16_t sink;
+  auto start = std::chrono::steady_clock::now();
+  {
+    Filter filter;
+    for (uint32_t i = 0; i < 10000000; ++i) {
+      sink = filter.push_and_get(static_cast<uint16_t>(i * 40503));
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  (void)sink;
+
+  printf("%-24s %6u %7u %8.2f %7.1f %8u %7.1f %6.2f\n", name, rise, settle,
+         sqrt(sum_squares / kNoiseSamples) / kLsb, peak / kLsb, updates,
+         lag / kLsb, elapsed.count() / 10000000);
+}
+
+} // namespace
+
+int FilterBench() {
+  printf("%-24s %6s %7s %8s %7s %8s %7s %6s\n", "filter", "rise", "settle",
+         "noise", "peak", "updates", "lag", "ns");
+  Bench<LegacyAverage>("RunningAverage<10>");
+  Bench<MovingAverage<3>>("MovingAverage<3>");
+  Bench<MovingAverage<4>>("MovingAverage<4>");
+  Bench<OnePole<3>>("OnePole<3>");
+  Bench<OnePole<5>>("OnePole<5>");
+  Bench<AdaptiveFilter<5, 1, 0x200, 0x20>>("AdaptiveFilter<5,1,..>");
+  Bench<AdaptiveFilter<6, 2, 0x200, 0x20>>("AdaptiveFilter<6,2,..>");
+  return 0;
+}
@@ -0,0 +1,112 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Simulated ATmega328P peripherals for the native build.
+
+#include "hal.h"
+
+#include <string.h>
+
+namespace clkr {
+namespace hal {
+
+Simulator simulator;
+
+void SimulatorReset() {
+  memset(&simulator, 0, sizeof(simulator));
+  memset(simulator.eeprom, 0xff, sizeof(simulator.eeprom));
+}
+
+uint64_t SimulatorNextMatch(uint16_t count) {
+  uint64_t now = simulator.cycle / kTimer1Prescaler;
+  uint32_t delta = static_cast<uint16_t>(count - now);
+  if (delta == 0) {
+    delta = 0x10000;
+  }
+  return (now + delta) * kTimer1Prescaler;
+}
+
+// Fire the next interrupt due up to (and including) the given cycle.
+// Returns true if a control rate tick happened.
+static bool FireNextEvent(uint64_t end) {
+  // EEPROM ready fires whenever it is enabled and no write is in progress
+  if (simulator.eeprom_ready_enabled) {
+    uint64_t ready = simulator.eeprom_ready > simulator.cycle
+                         ? simulator.eeprom_ready
+                         : simulator.cycle;
+    if (ready <= end &&
+        !(simulator.tick_enabled && simulator.next_tick < ready) &&
+        !(simulator.edge_enabled && simulator.next_edge < ready)) {
+      simulator.cycle = ready;
+      EE_READY_vect();
+      return false;
+    }
+  }
+
+  uint64_t next = end;
+  bool tick = simulator.tick_enabled && simulator.next_tick <= next;
+  if (tick) {
+    next = simulator.next_tick;
+  }
+  bool edge = simulator.edge_enabled && simulator.next_edge <= next;
+  if (edge) {
+    next = simulator.next_edge;
+    tick = tick && simulator.next_tick == next;
+  }
+  simulator.cycle = next;
+
+  // Without a new compare value, the match comes round again a wrap later
+  if (edge) {
+    simulator.next_edge += 0x10000 * kTimer1Prescaler;
+    TIMER1_COMPB_vect();
+  }
+  if (tick) {
+    simulator.next_tick += 0x10000 * kTimer1Prescaler;
+    TIMER1_COMPA_vect();
+  }
+  return tick;
+}
+
+void SimulatorAdvance(uint64_t cycles) {
+  uint64_t end = simulator.cycle + cycles;
+  while (simulator.cycle < end) {
+    FireNextEvent(end);
+  }
+}
+
+void SimulatorRun(uint64_t cycles) {
+  uint64_t end = simulator.cycle + cycles;
+  while (simulator.cycle < end) {
+    if (FireNextEvent(end) && simulator.main_loop) {
+      simulator.main_loop();
+    }
+  }
+}
+
+void SimulatorSetAdc(uint8_t channel, uint8_t value) {
+  simulator.adc[channel] = (value * 0x101) & ~(Adc::kReadingStep - 1);
+}
+
+void SimulatorSetPauseCv(bool high) {
+  if (high != simulator.pause_cv) {
+    simulator.pause_cv = high;
+    PCINT1_vect();
+  }
+}
+
+} // namespace hal
+} // namespace clkr
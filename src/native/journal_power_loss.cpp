@@ -0,0 +1,209 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host test of the settings journal against power loss. Each save runs
+// through the simulated EEPROM a byte write at a time, as the main loop and
+// EE_READY hand it over on the module, and the EEPROM is kept as power
+// loss would leave it at every point of the way:
+//
+//   - between byte writes, with every write before done and none after
+//   - during a byte write, with that one byte left holding garbage
+//
+// Booting from each of those must then load either the settings saved last
+// or the ones being saved, never a mix or nothing. One save in eight is cut
+// short for good, and the next goes on from what was left of it, as the
+// module would after a reboot. A few tens of thousands of saves wear every
+// slot hundreds of times over, and past 65536 the sequence number wraps.
+//
+// Before that, the first save after older firmware goes through the same
+// power losses, starting from its settings at 0x00 and 0x01 and no journal.
+// Booting the Clock from each must find either the legacy settings or the
+// saved ones.
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "clock.h"
+#include "eeprom_writer.h"
+#include "hal.h"
+#include "journal_power_loss.h"
+#include "settings_journal.h"
+
+using namespace clkr;
+using namespace clkr::hal;
+
+namespace {
+
+// One save in this many is cut short for good
+const unsigned kCutEvery = 8;
+
+struct Image {
+  uint8_t bytes[kEepromSize];
+};
+
+// The EEPROM as power loss at each point of the save in progress leaves it
+std::vector<Image> cuts;
+
+// Copied before it goes in, as eeprom may point into cuts
+void Keep(const uint8_t *eeprom) {
+  Image image;
+  memcpy(image.bytes, eeprom, kEepromSize);
+  cuts.push_back(image);
+}
+
+bool Same(const Settings &a, const Settings &b) {
+  return a.options == b.options && a.tempo == b.tempo &&
+         a.restart == b.restart;
+}
+
+// Write out the queued save, keeping the EEPROM before and during each byte
+// write in cuts
+void WriteSave() {
+  for (;;) {
+    // The main loop comes round once the write in progress is done
+    simulator.cycle = std::max(simulator.cycle, simulator.eeprom_ready);
+    SettingsJournal::Poll();
+    if (!simulator.eeprom_ready_enabled) {
+      return;
+    }
+    Keep(simulator.eeprom);
+    EE_READY_vect();
+    for (uint16_t i = 0; i < kEepromSize; ++i) {
+      if (simulator.eeprom[i] != cuts.back().bytes[i]) {
+        Keep(cuts.back().bytes);
+        cuts.back().bytes[i] = rand();
+        break;
+      }
+    }
+  }
+}
+
+void Print(const char *name, bool found, const Settings &settings) {
+  if (found) {
+    printf("  %-8s options %02x, tempo %u, restart %u\n", name,
+           settings.options, settings.tempo, settings.restart);
+  } else {
+    printf("  %-8s none\n", name);
+  }
+}
+
+// Boot older firmware's settings for every options byte, and cut power
+// during the first save to the journal. Returns false if a boot loses them.
+bool MigrateLegacy() {
+  unsigned long long checked = 0;
+  for (unsigned legacy_options = 0; legacy_options < 0xff; ++legacy_options) {
+    SimulatorReset();
+    simulator.eeprom[0x00] = legacy_options;
+    simulator.eeprom[0x01] = 20 + rand() % 236;
+    Clock::Init();
+    Settings legacy = Clock::settings();
+
+    Clock::set_tap_tempo(!Clock::tap_tempo());
+    Settings next = Clock::settings();
+    cuts.clear();
+    Clock::SaveSettings();
+    WriteSave();
+    Keep(simulator.eeprom);
+
+    for (size_t i = 0; i < cuts.size(); ++i) {
+      memcpy(simulator.eeprom, cuts[i].bytes, kEepromSize);
+      Clock::Init();
+      Settings loaded = Clock::settings();
+      bool complete = i + 1 == cuts.size();
+      if (Same(loaded, next) || (!complete && Same(loaded, legacy))) {
+        continue;
+      }
+      printf("legacy options %02x, power lost at point %u of %u:\n",
+             legacy_options, static_cast<unsigned>(i),
+             static_cast<unsigned>(cuts.size() - 1));
+      Print("loaded", true, loaded);
+      Print("legacy", true, legacy);
+      Print("saving", true, next);
+      fprintf(stderr, "FAIL: the first save lost the legacy settings\n");
+      return false;
+    }
+    checked += cuts.size();
+  }
+  fprintf(stderr, "255 legacy migrations, %llu boots checked\n", checked);
+  return true;
+}
+
+} // namespace
+
+int JournalPowerLoss(unsigned num_saves) {
+  srand(1);
+  if (!MigrateLegacy()) {
+    return 1;
+  }
+
+  SimulatorReset();
+
+  Settings saved = Settings();
+  bool any_saved = false;
+  unsigned long long checked = 0;
+  unsigned cut_short = 0;
+  for (unsigned save = 0; save < num_saves; ++save) {
+    Settings next;
+    next.options = rand();
+    next.tempo = rand();
+    next.restart = rand();
+
+    cuts.clear();
+    SettingsJournal::Save(next);
+    WriteSave();
+    Keep(simulator.eeprom);
+
+    // Boot from each, the complete save last
+    for (size_t i = 0; i < cuts.size(); ++i) {
+      memcpy(simulator.eeprom, cuts[i].bytes, kEepromSize);
+      Settings loaded;
+      bool found = SettingsJournal::Load(&loaded);
+      bool complete = i + 1 == cuts.size();
+      if (found ? Same(loaded, next) || (!complete && any_saved &&
+                                         Same(loaded, saved))
+                : !complete && !any_saved) {
+        continue;
+      }
+      printf("save %u, power lost at point %u of %u:\n", save,
+             static_cast<unsigned>(i), static_cast<unsigned>(cuts.size() - 1));
+      Print("loaded", found, loaded);
+      Print("saved", any_saved, saved);
+      Print("saving", true, next);
+      fprintf(stderr, "FAIL: the journal lost its settings\n");
+      return 1;
+    }
+    checked += cuts.size();
+
+    // Go on from the complete save, or now and then from a boot after one
+    // that never finished, once there is a record to fall back to
+    const Image *from = &cuts.back();
+    if (any_saved && rand() % kCutEvery == 0) {
+      from = &cuts[rand() % (cuts.size() - 1)];
+      ++cut_short;
+    }
+    memcpy(simulator.eeprom, from->bytes, kEepromSize);
+    any_saved = SettingsJournal::Load(&saved);
+  }
+
+  fprintf(stderr,
+          "%u saves over %u slots, %u cut short, %llu boots checked\n",
+          num_saves, SettingsJournal::kNumSlots, cut_short, checked);
+  return 0;
+}
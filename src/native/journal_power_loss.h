@@ -0,0 +1,26 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host test of the settings journal against power loss
+
+#pragma once
+
+// Saves random settings to the journal num_saves times, losing power before
+// and during every byte write of each save. Returns 1 if booting from what
+// any power loss leaves behind finds anything but the settings saved last
+// or the ones being saved.
+int JournalPowerLoss(unsigned num_saves);
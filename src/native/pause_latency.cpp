@@ -0,0 +1,287 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Host test of the pause engine's latency and restart modes. The firmware
+// boots once, locked at 120 BPM, and is taken through FAST at 24 PPQN, SLOW
+// and legacy mode with each restart mode in turn. Each pause comes at a
+// random point of the clock and lasts 2-40ms, or 50-900us for one in four,
+// which the glitch filter should let through unnoticed. For each pause:
+//
+//   resume      CV falling to the next rising edge, in us
+//   first_high  length of that first pulse, in us
+//
+// and the pause is a fault if
+//
+//   - the output rises while the CV is high
+//   - the output is still high after the CV has risen, as the native
+//     simulator has no interrupt latency of its own to add
+//   - a glitch moves the clock off its grid
+//   - a pulse or beat restart comes back with a short first pulse, or a beat
+//     restart on any other pulse
+//   - a phase reset takes longer than a tick to come back
+//
+// The native simulator runs each interrupt in no time, so the output falls
+// on the very cycle the CV rises and there is no gate off time to measure.
+// On the AVR that is the PCINT1 entry and handler, which the clkr_profile
+// build's ISR profile shows.
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "clock.h"
+#include "edge_scheduler.h"
+#include "firmware.h"
+#include "hal.h"
+#include "hardware_config.h"
+#include "pause.h"
+#include "pause_latency.h"
+
+using namespace clkr;
+using namespace clkr::hal;
+
+namespace {
+
+const uint16_t kBpm = 120;
+
+// Tenths of a second to wait for edges to time the period from
+const uint8_t kMaxWaits = 50;
+
+struct Edge {
+  uint64_t cycle;
+  uint8_t value;
+  bool beat;
+};
+
+std::vector<Edge> edges;
+
+void OnClockOut(uint64_t cycle, uint8_t value) {
+  // Legacy periods all count as beats, as they do to the pause
+  edges.push_back({cycle, value, Clock::legacy_mode() || Clock::on_beat()});
+}
+
+struct Mode {
+  const char *name;
+  bool slow;
+  bool legacy;
+};
+
+const Mode kModes[] = {
+    {"fast", false, false},
+    {"slow", true, false},
+    {"legacy", false, true},
+};
+
+const char *const kRestartNames[RESTART_LAST] = {"phase_reset", "immediate",
+                                                  "pulse", "beat"};
+
+double Random(double low, double high) {
+  return low + (high - low) * rand() / RAND_MAX;
+}
+
+// The last two rising edges at or after cycle, newest first. Returns false
+// if there haven't been two yet.
+bool LastRising(uint64_t cycle, uint64_t rising[2]) {
+  uint8_t found = 0;
+  for (size_t i = edges.size(); i-- > 0 && found < 2;) {
+    if (edges[i].cycle < cycle) {
+      break;
+    }
+    if (edges[i].value) {
+      rising[found++] = edges[i].cycle;
+    }
+  }
+  return found == 2;
+}
+
+// Index of the first edge at or after cycle
+size_t EdgeAt(uint64_t cycle) {
+  size_t i = edges.size();
+  while (i > 0 && edges[i - 1].cycle >= cycle) {
+    --i;
+  }
+  return i;
+}
+
+struct Summary {
+  unsigned pauses;
+  unsigned faults;
+  double resume_min;
+  double resume_max;
+  double resume_sum;
+  unsigned resumes;
+};
+
+} // namespace
+
+int PauseLatency(unsigned num_pauses) {
+  SimulatorReset();
+  SimulatorSetAdc(ADC_CHANNEL_TEMPO, 200);
+  SimulatorSetAdc(ADC_CHANNEL_TEMPO_CV, 255);
+  simulator.on_clock_out = &OnClockOut;
+  simulator.main_loop = &RunTasks;
+  Init();
+  srand(1);
+
+  // Scheduled edges land to the cycle, polled ones on a tick
+  const double tick = kUpdatePeriod * kTimer1Prescaler;
+  const double tolerance = kScheduledEdges ? 4 : tick;
+  const double us = 1e6 / F_CPU;
+
+  printf("mode,restart,hold_us,glitch,resume_us,first_high_us,fault\n");
+  fprintf(stderr, "%-6s %-11s %6s %6s  %s\n", "mode", "restart",
+          "pauses", "faults", "resume us min/mean/max");
+
+  bool ok = true;
+  for (const Mode &mode : kModes) {
+    SimulatorSetAdc(ADC_CHANNEL_SELECTOR, mode.slow ? 0xff : 0x00);
+    Clock::set_legacy_mode(mode.legacy);
+    Clock::set_clock_resolution(CLOCK_RESOLUTION_24_PPQN);
+    Clock::Update(BpmToTempo(kBpm), CLOCK_RESOLUTION_24_PPQN);
+    Clock::Lock();
+
+    // Time for ScanPots() to catch up, then only time the edges after it
+    edges.clear();
+    SimulatorRun(F_CPU);
+    uint64_t settled = simulator.cycle;
+
+    for (uint8_t r = 0; r < RESTART_LAST; ++r) {
+      RestartMode restart = static_cast<RestartMode>(r);
+      Clock::set_restart_mode(restart);
+      Summary summary = {0, 0, 1e30, 0.0, 0.0, 0};
+
+      for (unsigned n = 0; n < num_pauses; ++n) {
+        // The last rising edge going into the pause, and the period. Legacy
+        // periods are timed from the edges before, as the pot sets them, so
+        // wait for two since the clock settled or last came back.
+        uint64_t rising[2] = {0, 0};
+        for (uint8_t waits = 0; !LastRising(settled, rising); ++waits) {
+          if (waits == kMaxWaits) {
+            fprintf(stderr,
+                    "%s %s: harness error, no two rising edges to time "
+                    "the period from\n",
+                    mode.name, kRestartNames[r]);
+            return 1;
+          }
+          SimulatorRun(F_CPU / 10);
+        }
+        double period = F_CPU * 60.0 / kBpm;
+        if (mode.legacy) {
+          period = static_cast<double>(rising[0] - rising[1]);
+        } else if (!mode.slow) {
+          period /= ResolutionPpqn(CLOCK_RESOLUTION_24_PPQN);
+        }
+
+        SimulatorRun(static_cast<uint64_t>(Random(0.0, 2.0) * period));
+        bool glitch = rand() % 4 == 0;
+        double hold = glitch ? Random(50e-6, 900e-6) : Random(2e-3, 40e-3);
+        uint64_t held_at = simulator.cycle;
+        uint8_t level = simulator.clock_out;
+        size_t before = edges.size();
+        SimulatorSetPauseCv(true);
+        SimulatorRun(static_cast<uint64_t>(hold * F_CPU));
+        uint64_t released_at = simulator.cycle;
+        SimulatorSetPauseCv(false);
+        settled = released_at;
+        // A beat restart can be most of a beat away, legacy a whole period
+        SimulatorRun(static_cast<uint64_t>(
+            2 * std::max(period, F_CPU * 60.0 / kBpm) + tick));
+
+        bool fault = false;
+        if (level && (before == edges.size() ||
+                      edges[before].cycle != held_at ||
+                      edges[before].value)) {
+          fault = true;
+        }
+        size_t after = EdgeAt(released_at);
+        for (size_t j = before; j < after; ++j) {
+          fault = fault || edges[j].value;
+        }
+
+        // The first rising edge after the release, skipping one put back
+        // right away by a glitch, or an immediate restart, mid pulse
+        size_t first = after;
+        while (first < edges.size() && !edges[first].value) {
+          ++first;
+        }
+        bool put_back = first < edges.size() &&
+                        edges[first].cycle == released_at &&
+                        (glitch || restart == RESTART_IMMEDIATE);
+        if (put_back && glitch) {
+          for (++first; first < edges.size() && !edges[first].value;) {
+            ++first;
+          }
+        }
+        if (first + 1 >= edges.size()) {
+          fault = true; // never came back
+          printf("%s,%s,%.1f,%u,,,1\n", mode.name, kRestartNames[r],
+                 hold * 1e6, glitch);
+          ++summary.pauses;
+          ++summary.faults;
+          ok = false;
+          continue;
+        }
+        double resume = (edges[first].cycle - released_at) * us;
+        double first_high =
+            (edges[first + 1].cycle - edges[first].cycle) * us;
+
+        if (glitch) {
+          // Still on the grid of the edges before the pause
+          double offset = fmod(edges[first].cycle - rising[0], period);
+          fault = fault || std::min(offset, period - offset) > tolerance;
+        } else {
+          if (restart != RESTART_IMMEDIATE &&
+              first_high < (period / 2 - tolerance) * us) {
+            fault = true;
+          }
+          if (restart == RESTART_BEAT && !edges[first].beat) {
+            fault = true;
+          }
+          if (restart == RESTART_PHASE_RESET &&
+              resume > (EdgeScheduler::kMinimumInterval + tick) * us) {
+            fault = true;
+          }
+          summary.resume_min = std::min(summary.resume_min, resume);
+          summary.resume_max = std::max(summary.resume_max, resume);
+          summary.resume_sum += resume;
+          ++summary.resumes;
+        }
+
+        printf("%s,%s,%.1f,%u,%.3f,%.3f,%u\n", mode.name,
+               kRestartNames[r], hold * 1e6, glitch, resume, first_high,
+               fault);
+        ++summary.pauses;
+        if (fault) {
+          ++summary.faults;
+          ok = false;
+        }
+      }
+
+      fprintf(stderr, "%-6s %-11s %6u %6u  %.1f/%.1f/%.1f\n", mode.name,
+              kRestartNames[r], summary.pauses, summary.faults,
+              summary.resume_min,
+              summary.resumes ? summary.resume_sum / summary.resumes : 0.0,
+              summary.resume_max);
+    }
+  }
+
+  if (!ok) {
+    fprintf(stderr, "FAIL: see the pauses marked as faults\n");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Host test of the pause engine's latency and restart modes
+
+#pragma once
+
+// Pauses the firmware from the Pause CV num_pauses times in each of FAST,
+// SLOW and legacy mode, for every restart mode, at random points of the
+// clock and for random lengths, with some of them short enough to be
+// glitches. Prints a CSV line per pause and a summary per mode. Returns 1 if
+// the output ever goes high while paused, lags the CV going high, or comes
+// back in a way its restart mode rules out.
+int PauseLatency(unsigned num_pauses);
@@ -0,0 +1,324 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host replay of an input log from the clkr_recorder build (see
+// include/recorder.h). The firmware boots with the settings the module
+// booted with, then gets the logged inputs back on the ticks they were
+// logged on:
+//
+//   - ADC readings just before the main loop pass that took them
+//   - button levels just before the tick interrupt that read them
+//   - Pause CV edges to the cycle, from the tick and count they came at
+//
+// The native simulator runs the same clock engine, so the output edges come
+// out as the module's did, give or take the interrupt latency the simulator
+// doesn't have. Settings the module saved along the way are checked against
+// the replay's, as a sign that it went the same way.
+//
+//   avrdude -p m328p -c usbtiny -U eeprom:r:eeprom.bin:r
+//   .pio/build/native/program -R eeprom.bin -e > edges.csv
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "clock.h"
+#include "eeprom_writer.h"
+#include "firmware.h"
+#include "hal.h"
+#include "recorder.h"
+#include "replay.h"
+#include "settings_journal.h"
+#include "timebase.h"
+
+using namespace clkr;
+using namespace clkr::hal;
+
+namespace {
+
+enum InputType {
+  INPUT_ADC,
+  INPUT_BUTTON,
+  INPUT_PAUSE_CV,
+  INPUT_SETTINGS,
+};
+
+struct Input {
+  uint32_t tick;
+  InputType type;
+  uint8_t channel; // ADC channel, or the button or Pause CV level
+  uint16_t value;  // ADC reading, or Timer1 counts after the tick
+  Settings settings;
+};
+
+// The main loop's inputs, in the order they are due, the Pause CV's and the
+// tick the log ends on
+std::vector<Input> inputs;
+std::vector<Input> pause_cv;
+uint32_t end_tick;
+
+size_t next_input;
+size_t next_check;
+unsigned mismatches;
+
+bool print;
+uint64_t boot_cycle;
+uint32_t rising_edges;
+
+// The main loop pass of the tick an input is needed by
+uint32_t DueTick(const Input &input) {
+  if (input.type == INPUT_BUTTON && input.tick) {
+    return input.tick - 1;
+  }
+  return input.tick;
+}
+
+bool Load(const char *path, std::vector<uint8_t> *log, bool *full) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[256];
+  size_t size;
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + size);
+  }
+  fclose(file);
+
+  // Wherever a build put it in the EEPROM
+  LogHeader header;
+  for (size_t i = 0; i + sizeof(header) <= data.size(); ++i) {
+    memcpy(&header, &data[i], sizeof(header));
+    if (memcmp(header.magic, "CLKI", 4) || header.version != kLogVersion) {
+      continue;
+    }
+    size_t begin = i + sizeof(header);
+    if (begin + header.length > data.size()) {
+      break;
+    }
+    log->assign(data.begin() + begin, data.begin() + begin + header.length);
+    *full = header.full;
+    return true;
+  }
+  fprintf(stderr, "%s: no input log\n", path);
+  return false;
+}
+
+bool Decode(const std::vector<uint8_t> &log) {
+  uint16_t readings[kNumLoggedChannels] = {0};
+  uint32_t tick = 0;
+  size_t i = 0;
+  auto take16 = [&](uint16_t *value) {
+    if (i + 2 > log.size()) {
+      return false;
+    }
+    *value = log[i] | (log[i + 1] << 8);
+    i += 2;
+    return true;
+  };
+
+  while (i < log.size()) {
+    size_t at = i;
+    uint8_t code = log[i++];
+    Input input = {tick, INPUT_ADC, 0, 0, {0, 0, 0}};
+    uint8_t slot = (code >> 4) & 0x3;
+    bool ok = true;
+    bool wait = false;
+    if ((code & 0xc0) == LOG_WAIT) {
+      ok = code != LOG_WAIT;
+      tick += code & 0x3f;
+      wait = true;
+    } else if ((code & 0x40) && slot < kNumLoggedChannels) {
+      // LOG_ADC_DELTA or LOG_ADC_STEP
+      if ((code & 0xc0) == LOG_ADC_STEP) {
+        tick += kControlRate / 1000;
+        input.tick = tick;
+      }
+      int8_t delta = code & 0xf;
+      if (delta & 0x8) {
+        delta -= 16;
+      }
+      readings[slot] += delta * Adc::kReadingStep;
+      input.channel = kLoggedChannels[slot];
+      input.value = readings[slot];
+    } else if ((code & 0xcf) == LOG_ADC && slot < kNumLoggedChannels) {
+      ok = take16(&readings[slot]);
+      input.channel = kLoggedChannels[slot];
+      input.value = readings[slot];
+    } else if ((code & 0xfe) == LOG_BUTTON) {
+      input.type = INPUT_BUTTON;
+      input.channel = code & 1;
+    } else if ((code & 0xfe) == LOG_PAUSE_CV) {
+      input.type = INPUT_PAUSE_CV;
+      input.channel = code & 1;
+      ok = take16(&input.value);
+    } else if (code == LOG_SETTINGS) {
+      input.type = INPUT_SETTINGS;
+      ok = i + 4 <= log.size();
+      if (ok) {
+        input.settings.options = log[i];
+        input.settings.tempo = log[i + 1] | (log[i + 2] << 8);
+        input.settings.restart = log[i + 3];
+        i += 4;
+      }
+    } else if (code == LOG_LONG_WAIT) {
+      uint16_t ticks = 0;
+      ok = take16(&ticks);
+      tick += ticks;
+      wait = true;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr, "bad log entry 0x%02x at byte %u\n", code,
+              static_cast<unsigned>(at));
+      return false;
+    }
+    if (wait) {
+      continue;
+    }
+    if (input.type == INPUT_PAUSE_CV) {
+      pause_cv.push_back(input);
+    } else {
+      inputs.push_back(input);
+    }
+  }
+  end_tick = tick;
+
+  // Button levels go in a tick ahead of the rest
+  std::stable_sort(inputs.begin(), inputs.end(),
+                   [](const Input &a, const Input &b) {
+                     return DueTick(a) < DueTick(b);
+                   });
+  return true;
+}
+
+void OnClockOut(uint64_t cycle, uint8_t value) {
+  if (print) {
+    printf("%llu,%u\n", static_cast<unsigned long long>(cycle - boot_cycle),
+           value);
+  }
+  rising_edges += value;
+}
+
+// Stands in for the main loop, with the inputs due by this pass
+void ReplayLoop() {
+  uint32_t tick = Timebase::ticks();
+  for (; next_input < inputs.size() && DueTick(inputs[next_input]) <= tick;
+       ++next_input) {
+    const Input &input = inputs[next_input];
+    if (input.type == INPUT_ADC) {
+      simulator.adc[input.channel] = input.value;
+    } else if (input.type == INPUT_BUTTON) {
+      simulator.button = input.channel;
+    }
+  }
+  RunTasks();
+
+  // The saves the module made on this pass. The tempo follows the pots as
+  // soon as the pass is over, so only the options have to match.
+  for (; next_check < next_input; ++next_check) {
+    const Input &input = inputs[next_check];
+    if (input.type != INPUT_SETTINGS) {
+      continue;
+    }
+    Settings settings = Clock::settings();
+    if (settings.options != input.settings.options ||
+        settings.restart != input.settings.restart) {
+      fprintf(stderr,
+              "tick %u: module saved options 0x%02x restart %u, replay has "
+              "0x%02x restart %u\n",
+              static_cast<unsigned>(input.tick), input.settings.options,
+              input.settings.restart, settings.options, settings.restart);
+      ++mismatches;
+    }
+  }
+}
+
+// Leave settings in the EEPROM for the firmware to boot with, written the
+// way it writes them
+void PreloadSettings(const Settings &settings) {
+  SettingsJournal::Save(settings);
+  for (uint8_t i = 0; i < 3; ++i) {
+    SettingsJournal::Poll();
+    while (!EepromWriter::idle()) {
+      SimulatorAdvance(kEepromWriteCycles);
+    }
+  }
+}
+
+// Cycle of the given tick, from the first one after boot
+uint64_t TickCycle(uint64_t first_tick, uint32_t tick) {
+  return first_tick + (static_cast<int64_t>(tick) - 1) * kUpdatePeriod *
+                          kTimer1Prescaler;
+}
+
+} // namespace
+
+int Replay(const char *path, bool print_edges) {
+  std::vector<uint8_t> log;
+  bool full = false;
+  if (!Load(path, &log, &full) || !Decode(log)) {
+    return 1;
+  }
+  auto boot = std::find_if(inputs.begin(), inputs.end(), [](const Input &i) {
+    return i.type == INPUT_SETTINGS;
+  });
+  if (boot == inputs.end()) {
+    fprintf(stderr, "%s: no settings to boot with\n", path);
+    return 1;
+  }
+
+  print = print_edges;
+  SimulatorReset();
+  PreloadSettings(boot->settings);
+  simulator.on_clock_out = &OnClockOut;
+  simulator.main_loop = &ReplayLoop;
+  boot_cycle = simulator.cycle;
+  Init();
+  Clock::Update(Clock::tempo(), Clock::clock_resolution());
+  uint64_t first_tick = simulator.next_tick;
+
+  for (const Input &input : pause_cv) {
+    uint64_t cycle = TickCycle(first_tick, input.tick) + input.value;
+    if (cycle > simulator.cycle) {
+      SimulatorRun(cycle - simulator.cycle);
+    }
+    SimulatorSetPauseCv(input.channel);
+  }
+  uint64_t end = TickCycle(first_tick, end_tick);
+  if (end > simulator.cycle) {
+    SimulatorRun(end - simulator.cycle);
+  }
+
+  fprintf(stderr,
+          "replayed %.3f s, %u inputs, %u Pause CV edges, %u bytes%s\n",
+          static_cast<double>(end - boot_cycle) / F_CPU,
+          static_cast<unsigned>(inputs.size()),
+          static_cast<unsigned>(pause_cv.size()),
+          static_cast<unsigned>(log.size()),
+          full ? ", log full" : "");
+  fprintf(stderr, "rising edges: %u\n", rising_edges);
+  if (mismatches) {
+    fprintf(stderr, "%u saved settings differ\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host replay of an input log from the clkr_recorder build
+
+#pragma once
+
+// Boots the firmware with the settings from the log at path, an EEPROM image
+// read off a module or a bare log, and feeds its inputs back in tick by
+// tick. Prints every output edge as cycle,level, in cycles since boot, when
+// print_edges is set, and a summary. Returns 1 if the log can't be read, or
+// if the replay saves different settings to the ones the module saved.
+int Replay(const char *path, bool print_edges);
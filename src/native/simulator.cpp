@@ -0,0 +1,428 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Native simulator driver. Boots the firmware against the simulated
+// hardware, holds the inputs at fixed values and reports on the clock output.
+//
+//   pio run -e native && .pio/build/native/program -p 128 -t 60
+//
+// Built with CLKR_SYNC (env:native_sync), -S feeds a synthetic master clock
+// into the sync input and reports how the PLL locks on to it:
+//
+//   .pio/build/native_sync/program -S 8 -j 500 -T 8.8 -t 30
+//
+// -F skips the simulation and benchmarks the pot filters instead, see
+// filter_bench.cpp. -A sweeps the clock output's accuracy over every tempo
+// and resolution, see clock_accuracy.cpp:
+//
+//   .pio/build/native/program -A -t 10 -E 50 > accuracy.csv
+//
+// -I checks the phase increment of every 1/16 BPM step, see tempo_sweep.cpp.
+// -D stress tests DoubleBuffer, see double_buffer_stress.cpp. -J tests the
+// settings journal and its first save after older firmware against power
+// loss, see journal_power_loss.cpp. -G checks the generated lookup tables,
+// see table_check.cpp.
+//
+// -R plays back an input log from the clkr_recorder build, see replay.cpp.
+// Built with CLKR_RECORDER (env:native_recorder), -w dumps the simulated
+// run's own log through the EEPROM and saves the EEPROM image to a file
+// for -R.
+
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "clock.h"
+#include "clock_accuracy.h"
+#include "double_buffer_stress.h"
+#include "eeprom_writer.h"
+#include "filter_bench.h"
+#include "firmware.h"
+#include "hal.h"
+#include "hardware_config.h"
+#include "journal_power_loss.h"
+#include "pause_latency.h"
+#include "recorder.h"
+#include "replay.h"
+#include "table_check.h"
+#include "tempo_sweep.h"
+
+using namespace clkr;
+using namespace clkr::hal;
+
+static bool print_edges = false;
+static uint32_t rising_edges = 0;
+static uint64_t first_rising_edge = 0;
+static uint64_t last_rising_edge = 0;
+static std::vector<uint64_t> output_edges;
+
+static void OnClockOut(uint64_t cycle, uint8_t value) {
+  if (print_edges) {
+    printf("%llu,%u\n", static_cast<unsigned long long>(cycle), value);
+  }
+  if (value) {
+    if (!rising_edges) {
+      first_rising_edge = cycle;
+    }
+    last_rising_edge = cycle;
+    ++rising_edges;
+    output_edges.push_back(cycle);
+  }
+}
+
+// Drive a master clock into the sync input until the given cycle: 50% duty
+// pulses at hz, moving to step_hz half way if set, with every rising edge
+// shifted at random by up to +/- jitter_us. Returns where the rising edges
+// should have been, and stores where they were in input_edges.
+static std::vector<uint64_t> RunSync(uint64_t cycles, double hz,
+                                     double step_hz, double jitter_us,
+                                     std::vector<uint64_t> *input_edges) {
+  std::vector<uint64_t> nominal_edges;
+  srand(1);
+  double nominal = F_CPU / 10.0; // let the pots settle first
+  for (;;) {
+    double period = F_CPU / (step_hz > 0 && nominal >= cycles / 2 ? step_hz : hz);
+    double jitter = jitter_us * 1e-6 * F_CPU;
+    jitter = std::min(jitter, period / 4) * (2.0 * rand() / RAND_MAX - 1.0);
+    uint64_t edge = static_cast<uint64_t>(nominal + jitter);
+    if (edge + period / 2 >= cycles) {
+      break;
+    }
+    SimulatorRun(edge - simulator.cycle);
+    SimulatorSetPauseCv(true);
+    input_edges->push_back(edge);
+    nominal_edges.push_back(static_cast<uint64_t>(nominal));
+    SimulatorRun(static_cast<uint64_t>(period / 2));
+    SimulatorSetPauseCv(false);
+    nominal += period;
+  }
+  SimulatorRun(cycles - simulator.cycle);
+  return nominal_edges;
+}
+
+// Phase error of the output at each (jitter free) input edge, against the
+// nearest rising edge of the output, in cycles
+static std::vector<double> SyncErrors(const std::vector<uint64_t> &inputs) {
+  std::vector<double> errors;
+  for (uint64_t input : inputs) {
+    auto after = std::lower_bound(output_edges.begin(), output_edges.end(),
+                                  input);
+    double error = 1e30;
+    if (after != output_edges.end()) {
+      error = static_cast<double>(*after) - input;
+    }
+    if (after != output_edges.begin() &&
+        input - *(after - 1) < fabs(error)) {
+      error = -static_cast<double>(input - *(after - 1));
+    }
+    errors.push_back(error);
+  }
+  return errors;
+}
+
+// Lock time, then phase error and output period jitter once locked, over
+// the input edges [begin, end). Locked means every following phase error is
+// within 0.5% of the input period, or twice the input jitter if that is more.
+static void ReportSync(const char *name, const std::vector<uint64_t> &nominal,
+                       const std::vector<uint64_t> &inputs,
+                       const std::vector<double> &errors, size_t begin,
+                       size_t end, double hz, double jitter_us) {
+  double period = F_CPU / hz;
+  double tolerance = std::max(period * 0.005, 2e-6 * jitter_us * F_CPU);
+  size_t lock = end;
+  while (lock > begin && fabs(errors[lock - 1]) < tolerance) {
+    --lock;
+  }
+  if (end - lock < 2) {
+    fprintf(stderr, "%s: %.3f Hz input, no lock\n", name, hz);
+    return;
+  }
+
+  double sum = 0.0, sum_squares = 0.0, worst = 0.0;
+  double input_squares = 0.0, output_squares = 0.0;
+  for (size_t i = lock; i < end; ++i) {
+    sum += errors[i];
+    sum_squares += errors[i] * errors[i];
+    worst = std::max(worst, fabs(errors[i]));
+    if (i > lock) {
+      double input_period = static_cast<double>(inputs[i] - inputs[i - 1]);
+      double output_period = static_cast<double>(nominal[i] - nominal[i - 1]) +
+                             errors[i] - errors[i - 1];
+      input_squares += (input_period - period) * (input_period - period);
+      output_squares += (output_period - period) * (output_period - period);
+    }
+  }
+  size_t count = end - lock;
+  double us = 1e6 / F_CPU;
+  fprintf(stderr,
+          "%s: %.3f Hz input, locked after %.3f s (%u input periods)\n"
+          "  phase error mean %.1f us, rms %.1f us, max %.1f us\n"
+          "  period jitter rms, input %.1f us, output %.1f us\n",
+          name, hz,
+          (nominal[lock] - nominal[begin]) / static_cast<double>(F_CPU),
+          static_cast<unsigned>(lock - begin), sum / count * us,
+          sqrt(sum_squares / count) * us, worst * us,
+          sqrt(input_squares / (count - 1)) * us,
+          sqrt(output_squares / (count - 1)) * us);
+}
+
+#ifdef CLKR_RECORDER
+// Dump the input log as the module does, then save the EEPROM the way
+// avrdude reads it back
+static bool SaveEeprom(const char *path) {
+  Recorder::Dump();
+  for (uint8_t i = 0; i <= kRecorderEepromSize / EepromWriter::kQueueSize;
+       ++i) {
+    Recorder::Poll();
+    while (!EepromWriter::idle()) {
+      SimulatorAdvance(kEepromWriteCycles);
+    }
+  }
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  fwrite(simulator.eeprom, 1, sizeof(simulator.eeprom), file);
+  fclose(file);
+  return true;
+}
+#endif
+
+static void Usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-t seconds] [-p pot] [-c cv] [-r resolution] [-s] [-l] "
+          "[-L] [-X] [-e] [-S hz [-j us] [-T hz]] [-F] [-A [-E ppm]] "
+          "[-P pauses] [-I] [-D writes] [-J saves] [-G] [-R log] [-w eeprom]\n"
+          "  -t  simulated time in seconds (default 10)\n"
+          "  -p  rate pot ADC reading, 0-255 (default 128)\n"
+          "  -c  tempo CV ADC reading, 0-255, 255 is 0V (default 255)\n"
+          "  -r  clock resolution: 0 = 4, 1 = 8, 2 = 24, 3 = 48, 4 = 96 PPQN "
+          "(default 2)\n"
+          "  -s  range switch in the SLOW (left) position\n"
+          "  -l  legacy mode\n"
+          "  -L  logarithmic legacy response (tap tempo in Grids mode)\n"
+          "  -X  exponential legacy response\n"
+          "  -e  print every output edge as cycle,level\n"
+          "  -S  master clock rate on the sync input (CLKR_SYNC builds)\n"
+          "  -j  random jitter on every sync edge, +/- microseconds\n"
+          "  -T  master clock rate for the second half of the run\n"
+          "  -F  benchmark the pot smoothing filters and exit\n"
+          "  -A  sweep every BPM and resolution, -t seconds each, print "
+          "CSV and exit\n"
+          "  -E  with -A, fail if a mean period is off by more than this "
+          "(default 100 ppm)\n"
+          "  -P  pause from the Pause CV this many times in every mode and "
+          "restart mode, print CSV and exit\n"
+          "  -I  check the phase increment of every 1/16 BPM step, print "
+          "CSV and exit\n"
+          "  -D  write this many values through a DoubleBuffer, reading "
+          "at every byte, and exit\n"
+          "  -J  save this many times, the first after older firmware, "
+          "losing power at every byte, and exit\n"
+          "  -G  check the generated lookup tables against the old ones "
+          "and exit\n"
+          "  -R  replay an input log (EEPROM image) and exit, -e prints "
+          "the edges\n"
+          "  -w  dump the input log and save the EEPROM image to this file "
+          "(CLKR_RECORDER builds)\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  double seconds = 10.0;
+  Options options = {CLOCK_RESOLUTION_24_PPQN, false, false, false,
+                     LEGACY_CURVE_LINEAR, RESTART_PHASE_RESET};
+  uint8_t pot = 128;
+  uint8_t cv = 255;
+  bool slow = false;
+  double sync_hz = 0.0;
+  double sync_step_hz = 0.0;
+  double sync_jitter = 0.0;
+  bool accuracy = false;
+  double max_error_ppm = 100.0;
+  unsigned pauses = 0;
+  const char *replay = NULL;
+  const char *eeprom_image = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "t:p:c:r:slLXeS:j:T:FAE:P:ID:J:GR:w:")) !=
+         -1) {
+    switch (opt) {
+    case 't':
+      seconds = atof(optarg);
+      break;
+    case 'p':
+      pot = atoi(optarg);
+      break;
+    case 'c':
+      cv = atoi(optarg);
+      break;
+    case 'r':
+      options.clock_resolution = static_cast<ClockResolution>(atoi(optarg));
+      break;
+    case 's':
+      slow = true;
+      break;
+    case 'l':
+      options.legacy_mode = true;
+      break;
+    case 'L':
+      options.tap_tempo = true;
+      options.legacy_curve = LEGACY_CURVE_LOG;
+      break;
+    case 'X':
+      options.legacy_curve = LEGACY_CURVE_EXP;
+      break;
+    case 'e':
+      print_edges = true;
+      break;
+    case 'S':
+      sync_hz = atof(optarg);
+      break;
+    case 'j':
+      sync_jitter = atof(optarg);
+      break;
+    case 'T':
+      sync_step_hz = atof(optarg);
+      break;
+    case 'F':
+      return FilterBench();
+    case 'A':
+      accuracy = true;
+      break;
+    case 'E':
+      max_error_ppm = atof(optarg);
+      break;
+    case 'P':
+      pauses = atoi(optarg);
+      break;
+    case 'I':
+      return TempoSweep();
+    case 'D':
+      return DoubleBufferStress(atoi(optarg));
+    case 'J':
+      return JournalPowerLoss(atoi(optarg));
+    case 'G':
+      return TableCheck();
+    case 'R':
+      replay = optarg;
+      break;
+    case 'w':
+      eeprom_image = optarg;
+      break;
+    default:
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (replay) {
+    return Replay(replay, print_edges);
+  }
+
+  if (accuracy) {
+    return ClockAccuracy(seconds, max_error_ppm);
+  }
+
+  if (pauses) {
+    if (kSyncInput) {
+      fprintf(stderr, "-P needs the Pause CV, which CLKR_SYNC builds take "
+                      "for sync\n");
+      return 1;
+    }
+    return PauseLatency(pauses);
+  }
+
+  if (sync_hz > 0 && !kSyncInput) {
+    fprintf(stderr, "-S needs a CLKR_SYNC build (pio run -e native_sync)\n");
+    return 1;
+  }
+
+#ifndef CLKR_RECORDER
+  if (eeprom_image) {
+    fprintf(stderr,
+            "-w needs a CLKR_RECORDER build (pio run -e native_recorder)\n");
+    return 1;
+  }
+#endif
+
+  SimulatorReset();
+  // Settings as older firmware stored them, moved into the journal at boot
+  simulator.eeprom[0x00] = options.pack();
+  simulator.eeprom[0x01] = 120;
+  SimulatorSetAdc(ADC_CHANNEL_TEMPO, pot);
+  SimulatorSetAdc(ADC_CHANNEL_TEMPO_CV, cv);
+  SimulatorSetAdc(ADC_CHANNEL_SELECTOR, slow ? 0xff : 0x00);
+  simulator.on_clock_out = &OnClockOut;
+  simulator.main_loop = &RunTasks;
+
+  Init();
+  Clock::Update(Clock::tempo(), Clock::clock_resolution());
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t cycles = static_cast<uint64_t>(seconds * F_CPU);
+  std::vector<uint64_t> sync_edges;
+  std::vector<uint64_t> nominal_edges;
+  if (sync_hz > 0) {
+    nominal_edges =
+        RunSync(cycles, sync_hz, sync_step_hz, sync_jitter, &sync_edges);
+  } else {
+    SimulatorRun(cycles);
+  }
+  std::chrono::duration<double> elapsed_time =
+      std::chrono::steady_clock::now() - start;
+  double elapsed = elapsed_time.count();
+
+  double ticks = static_cast<double>(cycles) / (kUpdatePeriod * kTimer1Prescaler);
+  fprintf(stderr, "simulated %.1f s (%.0f ticks) in %.3f s, %.2f Mticks/s\n",
+          seconds, ticks, elapsed, ticks / elapsed / 1e6);
+  fprintf(stderr, "rising edges: %u\n", rising_edges);
+  if (rising_edges > 1) {
+    double period = static_cast<double>(last_rising_edge - first_rising_edge) /
+                    (rising_edges - 1) / F_CPU;
+    fprintf(stderr, "mean period: %.6f s (%.3f Hz)\n", period, 1.0 / period);
+  }
+
+  if (!sync_edges.empty()) {
+    std::vector<double> errors = SyncErrors(nominal_edges);
+    size_t step = sync_edges.size();
+    if (sync_step_hz > 0) {
+      step = std::lower_bound(sync_edges.begin(), sync_edges.end(),
+                              cycles / 2) -
+             sync_edges.begin();
+    }
+    fprintf(stderr, "sync edges: %u\n", static_cast<unsigned>(sync_edges.size()));
+    ReportSync("sync", nominal_edges, sync_edges, errors, 0, step, sync_hz,
+               sync_jitter);
+    if (step < sync_edges.size()) {
+      ReportSync("step", nominal_edges, sync_edges, errors, step,
+                 sync_edges.size(), sync_step_hz, sync_jitter);
+    }
+  }
+
+#ifdef CLKR_RECORDER
+  if (eeprom_image && !SaveEeprom(eeprom_image)) {
+    return 1;
+  }
+#endif
+  return 0;
+}
@@ -0,0 +1,145 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host sweep of the clock's phase increments. For every 1/16 BPM step from
+// 20 to 480 BPM at each resolution, TempoScale's increment is compared with
+// the exact one, tempo / 16 * ppqn / 60 / kControlRate * 2^31:
+//
+//   ppqn, bpm   the resolution and the tempo
+//   increment   TempoScale<ppqn>::PhaseIncrement()
+//   error       its difference from the exact increment, in increments and
+//               in ppm of it
+//
+// The scale is rounded to 1/65536 and the fractional half of the multiply
+// is truncated, so an increment can be off by up to 1 + tempo / 2^17. At
+// the whole BPM and resolutions it had entries for, the worst error is also
+// held against that of the 512 entry table the increments used to be read
+// from, which had to be matched or beaten.
+//
+// A CSV line per step goes to stdout, and a summary of each resolution to
+// stderr.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "clock.h"
+#include "tempo_sweep.h"
+
+using namespace clkr;
+
+namespace {
+
+const uint16_t kMinTempo = BpmToTempo(20);
+const uint16_t kMaxTempo = BpmToTempo(480);
+
+// lut_res_tempo_phase_increment from the old resources/lookup_tables.py,
+// rounded down, at 8 PPQN
+uint32_t OldTableEntry(uint16_t bpm) {
+  return (static_cast<uint64_t>(bpm) * 8 << 31) / (60UL * kControlRate);
+}
+
+// How the old Clock::Update() scaled it to each resolution. Returns false
+// for the ones it didn't have.
+bool OldIncrement(uint8_t ppqn, uint16_t bpm, uint32_t *increment) {
+  uint32_t entry = OldTableEntry(bpm);
+  switch (ppqn) {
+  case 4:
+    *increment = entry >> 1;
+    return true;
+  case 8:
+    *increment = entry;
+    return true;
+  case 24:
+    *increment = (entry << 1) + entry;
+    return true;
+  default:
+    return false;
+  }
+}
+
+double Exact(uint8_t ppqn, uint16_t tempo) {
+  return static_cast<double>(tempo) / (1 << kTempoFractionalBits) * ppqn /
+         60.0 / kControlRate * 2147483648.0;
+}
+
+template <uint8_t ppqn> bool Sweep() {
+  double worst = 0;
+  double worst_ppm = 0;
+  uint16_t worst_tempo = kMinTempo;
+  double worst_whole = 0;
+  double worst_old = 0;
+  bool has_old = false;
+  bool ok = true;
+  for (uint16_t tempo = kMinTempo; tempo <= kMaxTempo; ++tempo) {
+    uint32_t increment = TempoScale<ppqn>::PhaseIncrement(tempo);
+    double exact = Exact(ppqn, tempo);
+    double error = increment - exact;
+    double ppm = error / exact * 1e6;
+    printf("%u,%.4f,%lu,%.3f,%.3f\n", ppqn,
+           static_cast<double>(tempo) / (1 << kTempoFractionalBits),
+           static_cast<unsigned long>(increment), error, ppm);
+
+    if (fabs(error) >= 1 + tempo / 131072.0) {
+      ok = false;
+    }
+    if (fabs(error) > fabs(worst)) {
+      worst = error;
+      worst_tempo = tempo;
+    }
+    if (fabs(ppm) > fabs(worst_ppm)) {
+      worst_ppm = ppm;
+    }
+
+    uint32_t old;
+    if (!(tempo & ((1 << kTempoFractionalBits) - 1)) &&
+        OldIncrement(ppqn, tempo >> kTempoFractionalBits, &old)) {
+      has_old = true;
+      worst_whole = fmax(worst_whole, fabs(error) / exact * 1e6);
+      worst_old = fmax(worst_old, fabs(old - exact) / exact * 1e6);
+    }
+  }
+  if (has_old && worst_whole > worst_old) {
+    ok = false;
+  }
+
+  fprintf(stderr, "%2u ppqn  worst %6.3f at %8.4f BPM, %6.3f ppm",
+          ppqn, worst,
+          static_cast<double>(worst_tempo) / (1 << kTempoFractionalBits),
+          worst_ppm);
+  if (has_old) {
+    fprintf(stderr, "  whole BPM %.3f ppm, old table %.3f ppm", worst_whole,
+            worst_old);
+  }
+  fprintf(stderr, "%s\n", ok ? "" : "  FAIL");
+  return ok;
+}
+
+} // namespace
+
+int TempoSweep() {
+  printf("ppqn,bpm,increment,error,error_ppm\n");
+  bool ok = Sweep<4>();
+  ok = Sweep<8>() && ok;
+  ok = Sweep<24>() && ok;
+  ok = Sweep<48>() && ok;
+  ok = Sweep<96>() && ok;
+  if (!ok) {
+    fprintf(stderr, "FAIL: see the resolutions marked above\n");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Host sweep of the clock's phase increments
+
+#pragma once
+
+// Works out the phase increment for every 1/16 BPM step from 20 to 480 BPM
+// at every resolution, and compares it with the exact one. Prints a CSV line
+// per step and a summary per resolution. Returns 1 if any is further off
+// than the fixed point scale can explain, or does worse at a whole BPM than
+// the table it replaced.
+int TempoSweep();
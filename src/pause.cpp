@@ -0,0 +1,67 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Pause engine.
+
+#include "pause.h"
+
+namespace clkr {
+
+/* static */
+volatile Pause::State Pause::state_;
+
+/* static */
+Pause::State Pause::resume_state_;
+
+/* static */
+uint32_t Pause::held_at_;
+
+/* static */
+bool Pause::wait_for_beat_;
+
+/* static */
+bool Pause::last_level_;
+
+/* static */
+PauseAction Pause::Release(uint32_t time, RestartMode mode) {
+  if (state_ != STATE_HELD) {
+    return PAUSE_ACTION_NONE;
+  }
+
+  // Too short to be meant, carry on from where the glitch found us
+  if (time - held_at_ < kGlitchFilter) {
+    state_ = resume_state_;
+    return state_ == STATE_RUNNING ? PAUSE_ACTION_FOLLOW : PAUSE_ACTION_NONE;
+  }
+
+  switch (mode) {
+  case RESTART_IMMEDIATE:
+    state_ = STATE_RUNNING;
+    return PAUSE_ACTION_FOLLOW;
+
+  case RESTART_PULSE:
+  case RESTART_BEAT:
+    state_ = STATE_ARMED;
+    wait_for_beat_ = mode == RESTART_BEAT;
+    return PAUSE_ACTION_NONE;
+
+  default:
+    state_ = STATE_RUNNING;
+    return PAUSE_ACTION_RESTART;
+  }
+}
+
+} // namespace clkr
@@ -0,0 +1,130 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Interrupt handler profiling, for the clkr_profile build.
+
+#include "profiler.h"
+
+#ifdef CLKR_PROFILE
+
+#include <string.h>
+
+#include "eeprom_writer.h"
+
+namespace clkr {
+
+/* static */
+Profiler::Block Profiler::profile_ = {
+    {{'C', 'L', 'K', 'P'}, Profiler::kVersion, PROFILE_LAST},
+    {
+        {0, 0, 0xffff, 0, 0, 0},
+        {0, 0, 0xffff, 0, 0, 0},
+        {0, 0, 0xffff, 0, 0, 0},
+    },
+};
+
+/* static */
+uint8_t Profiler::active_;
+
+/* static */
+IsrProfile Profiler::snapshot_[PROFILE_LAST];
+
+/* static */
+uint8_t Profiler::dump_offset_ = Profiler::kDumpSize;
+
+static_assert(Profiler::kDumpSize <= kProfileEepromSize,
+              "the dump doesn't fit its EEPROM space");
+
+static bool Pending(ProfiledIsr isr) {
+  switch (isr) {
+  case PROFILE_TICK:
+    return hal::TickTimer::pending();
+  case PROFILE_EDGE:
+    return hal::EdgeTimer::pending();
+  default:
+    return hal::PauseCv::pending();
+  }
+}
+
+/* static */
+void Profiler::Enter(ProfiledIsr isr, uint16_t entry, uint16_t due) {
+  IsrProfile &profile = profile_.isrs[isr];
+  uint8_t mask = 1 << isr;
+  if (active_ & mask) {
+    ++profile.overruns; // came round again before it was done
+  }
+  active_ |= mask;
+  uint16_t latency = entry - due;
+  if (latency > profile.max_latency) {
+    profile.max_latency = latency;
+  }
+}
+
+/* static */
+void Profiler::Exit(ProfiledIsr isr, uint16_t entry) {
+  hal::InterruptLock lock; // the tick handler gets here preemptible
+  uint16_t cycles = hal::TickTimer::now() - entry;
+  IsrProfile &profile = profile_.isrs[isr];
+  // Halve the sums rather than let them wrap, keeping the average
+  if (profile.total & 0x80000000UL) {
+    profile.total >>= 1;
+    profile.count >>= 1;
+  }
+  ++profile.count;
+  profile.total += cycles;
+  if (cycles < profile.min) {
+    profile.min = cycles;
+  }
+  if (cycles > profile.max) {
+    profile.max = cycles;
+  }
+  active_ &= ~(1 << isr);
+  if (Pending(isr)) {
+    ++profile.overruns;
+  }
+}
+
+/* static */
+void Profiler::Dump() {
+  hal::InterruptLock lock;
+  memcpy(snapshot_, profile_.isrs, sizeof(snapshot_));
+  dump_offset_ = 0;
+}
+
+/* static */
+void Profiler::Poll() {
+  // Only into an empty queue, so the settings journal always finds room
+  if (dump_offset_ >= kDumpSize || !EepromWriter::idle()) {
+    return;
+  }
+  const uint8_t *header = reinterpret_cast<const uint8_t *>(&profile_.header);
+  const uint8_t *isrs = reinterpret_cast<const uint8_t *>(snapshot_);
+  for (uint8_t i = 0; i < EepromWriter::kQueueSize; ++i) {
+    if (dump_offset_ >= kDumpSize) {
+      break;
+    }
+    uint8_t value = dump_offset_ < sizeof(ProfileHeader)
+                        ? header[dump_offset_]
+                        : isrs[dump_offset_ - sizeof(ProfileHeader)];
+    EepromWriter::Write(kEepromAddress + dump_offset_, value);
+    ++dump_offset_;
+  }
+}
+
+} // namespace clkr
+
+#endif // CLKR_PROFILE
@@ -0,0 +1,237 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Input event recorder, for the clkr_recorder build.
+
+#include "recorder.h"
+
+#ifdef CLKR_RECORDER
+
+#include <string.h>
+
+#include "eeprom_writer.h"
+#include "settings_journal.h"
+#include "timebase.h"
+
+namespace clkr {
+
+/* static */
+LogHeader Recorder::header_ = {{'C', 'L', 'K', 'I'}, kLogVersion, 0, 0};
+
+/* static */
+LogHeader Recorder::dump_header_;
+
+/* static */
+uint8_t Recorder::log_[kLogSize];
+
+/* static */
+uint32_t Recorder::last_tick_;
+
+/* static */
+uint16_t Recorder::readings_[kNumLoggedChannels];
+
+/* static */
+uint8_t Recorder::button_;
+
+/* static */
+uint16_t Recorder::dump_length_;
+
+/* static */
+uint16_t Recorder::dump_offset_;
+
+static_assert(Recorder::kEepromAddress >=
+                  SettingsJournal::kNumSlots * SettingsJournal::kRecordSize,
+              "the dump overlaps the settings journal");
+
+// Ticks between main loop scans of the pots, which LOG_ADC_STEP assumes
+const uint8_t kStepTicks = kControlRate / 1000;
+
+// Bytes kept back for the wait that closes the log in Dump()
+const uint8_t kCloseSize = 3;
+
+static uint8_t WaitSize(uint32_t ticks) {
+  if (!ticks) {
+    return 0;
+  }
+  if (ticks < 64) {
+    return 1;
+  }
+  return 3 * ((ticks + 0xfffe) / 0xffff);
+}
+
+/* static */
+void Recorder::Start(const Settings &settings) {
+  {
+    hal::InterruptLock lock;
+    header_.full = false;
+    header_.length = 0;
+    last_tick_ = Timebase::ticks();
+    memset(readings_, 0, sizeof(readings_));
+    button_ = 0;
+  }
+  SettingsChanged(settings);
+}
+
+/* static */
+void Recorder::Append(uint8_t value) { log_[header_.length++] = value; }
+
+/* static */
+void Recorder::Append16(uint16_t value) {
+  Append(value);
+  Append(value >> 8);
+}
+
+/* static */
+void Recorder::Wait(uint32_t ticks) {
+  last_tick_ += ticks;
+  while (ticks >= 64) {
+    uint16_t wait = ticks > 0xffff ? 0xffff : ticks;
+    Append(LOG_LONG_WAIT);
+    Append16(wait);
+    ticks -= wait;
+  }
+  if (ticks) {
+    Append(LOG_WAIT | ticks);
+  }
+}
+
+/* static */
+bool Recorder::Begin(uint32_t ticks, uint8_t size) {
+  if (header_.full) {
+    return false;
+  }
+  if (header_.length + WaitSize(ticks) + size + kCloseSize > kLogSize) {
+    header_.full = true;
+    return false;
+  }
+  Wait(ticks);
+  return true;
+}
+
+/* static */
+void Recorder::Reading(uint8_t channel, uint16_t value) {
+  uint8_t slot = 0;
+  while (kLoggedChannels[slot] != channel) {
+    if (++slot >= kNumLoggedChannels) {
+      return;
+    }
+  }
+  hal::InterruptLock lock;
+  int16_t delta = value - readings_[slot];
+  if (!delta) {
+    return;
+  }
+  uint32_t ticks = Timebase::ticks() - last_tick_;
+  const int16_t step = hal::Adc::kReadingStep;
+  if (!(delta % step) && delta >= -8 * step && delta < 8 * step) {
+    uint8_t code = (slot << 4) | ((delta / step) & 0xf);
+    if (ticks == kStepTicks) {
+      if (!Begin(0, 1)) {
+        return;
+      }
+      last_tick_ += kStepTicks;
+      Append(LOG_ADC_STEP | code);
+    } else {
+      if (!Begin(ticks, 1)) {
+        return;
+      }
+      Append(LOG_ADC_DELTA | code);
+    }
+  } else {
+    if (!Begin(ticks, 3)) {
+      return;
+    }
+    Append(LOG_ADC | (slot << 4));
+    Append16(value);
+  }
+  readings_[slot] = value;
+}
+
+/* static */
+void Recorder::ButtonLevel(uint8_t level) {
+  level = level ? 1 : 0;
+  if (level == button_) {
+    return;
+  }
+  hal::InterruptLock lock;
+  if (!Begin(Timebase::ticks() - last_tick_, 1)) {
+    return;
+  }
+  Append(LOG_BUTTON | level);
+  button_ = level;
+}
+
+/* static */
+void Recorder::PauseCvEdge(bool level, uint32_t time) {
+  hal::InterruptLock lock;
+  if (!Begin(Timebase::ticks() - last_tick_, 3)) {
+    return;
+  }
+  Append(LOG_PAUSE_CV | level);
+  // Counts after the tick, back at the time of the edge
+  Append16(Timebase::since_tick() -
+           static_cast<uint16_t>(Timebase::now() - time));
+}
+
+/* static */
+void Recorder::SettingsChanged(const Settings &settings) {
+  hal::InterruptLock lock;
+  if (!Begin(Timebase::ticks() - last_tick_, 5)) {
+    return;
+  }
+  Append(LOG_SETTINGS);
+  Append(settings.options);
+  Append16(settings.tempo);
+  Append(settings.restart);
+}
+
+/* static */
+void Recorder::Dump() {
+  hal::InterruptLock lock;
+  // Run the log up to now, unless it stopped short. Anything past a long
+  // wait's worth is left for the next event.
+  if (!header_.full) {
+    uint32_t ticks = Timebase::ticks() - last_tick_;
+    Wait(ticks > 0xffff ? 0xffff : ticks);
+  }
+  dump_header_ = header_;
+  dump_length_ = sizeof(LogHeader) + header_.length;
+  dump_offset_ = 0;
+}
+
+/* static */
+void Recorder::Poll() {
+  // Only into an empty queue, so the settings journal always finds room
+  if (dump_offset_ >= dump_length_ || !EepromWriter::idle()) {
+    return;
+  }
+  const uint8_t *header = reinterpret_cast<const uint8_t *>(&dump_header_);
+  for (uint8_t i = 0; i < EepromWriter::kQueueSize; ++i) {
+    if (dump_offset_ >= dump_length_) {
+      break;
+    }
+    uint8_t value = dump_offset_ < sizeof(LogHeader)
+                        ? header[dump_offset_]
+                        : log_[dump_offset_ - sizeof(LogHeader)];
+    EepromWriter::Write(kEepromAddress + dump_offset_, value);
+    ++dump_offset_;
+  }
+}
+
+} // namespace clkr
+
+#endif // CLKR_RECORDER
@@ -1,203 +1,30 @@
-// Copyright 2012 Emilie Gillet, 2023 Katherine Whitlock
-//
-// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
-//         Katherine Whitlock (kate@skylinesynths.nyc)
-//
-// This program is free software: you can redistribute it and/or modify
-// it under the terms of the GNU General Public License as published by
-// the Free Software Foundation, either version 3 of the License, or
-// (at your option) any later version.
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-// You should have received a copy of the GNU General Public License
-// along with this program.  If not, see <http://www.gnu.org/licenses/>.
-//
-// -----------------------------------------------------------------------------
-//
-// Resources definitions.
-
-#include "resources.h"
-
-namespace clkr {
-const uint32_t lut_res_tempo_phase_increment[] PROGMEM = {
-    0,        35791,    71582,    107374,   143165,   178956,   214748,
-    250539,   286331,   322122,   357913,   393705,   429496,   465288,
-    501079,   536870,   572662,   608453,   644245,   680036,   715827,
-    751619,   787410,   823202,   858993,   894784,   930576,   966367,
-    1002159,  1037950,  1073741,  1109533,  1145324,  1181116,  1216907,
-    1252698,  1288490,  1324281,  1360072,  1395864,  1431655,  1467447,
-    1503238,  1539029,  1574821,  1610612,  1646404,  1682195,  1717986,
-    1753778,  1789569,  1825361,  1861152,  1896943,  1932735,  1968526,
-    2004318,  2040109,  2075900,  2111692,  2147483,  2183275,  2219066,
-    2254857,  2290649,  2326440,  2362232,  2398023,  2433814,  2469606,
-    2505397,  2541188,  2576980,  2612771,  2648563,  2684354,  2720145,
-    2755937,  2791728,  2827520,  2863311,  2899102,  2934894,  2970685,
-    3006477,  3042268,  3078059,  3113851,  3149642,  3185434,  3221225,
-    3257016,  3292808,  3328599,  3364391,  3400182,  3435973,  3471765,
-    3507556,  3543348,  3579139,  3614930,  3650722,  3686513,  3722304,
-    3758096,  3793887,  3829679,  3865470,  3901261,  3937053,  3972844,
-    4008636,  4044427,  4080218,  4116010,  4151801,  4187593,  4223384,
-    4259175,  4294967,  4330758,  4366550,  4402341,  4438132,  4473924,
-    4509715,  4545507,  4581298,  4617089,  4652881,  4688672,  4724464,
-    4760255,  4796046,  4831838,  4867629,  4903420,  4939212,  4975003,
-    5010795,  5046586,  5082377,  5118169,  5153960,  5189752,  5225543,
-    5261334,  5297126,  5332917,  5368709,  5404500,  5440291,  5476083,
-    5511874,  5547666,  5583457,  5619248,  5655040,  5690831,  5726623,
-    5762414,  5798205,  5833997,  5869788,  5905580,  5941371,  5977162,
-    6012954,  6048745,  6084537,  6120328,  6156119,  6191911,  6227702,
-    6263493,  6299285,  6335076,  6370868,  6406659,  6442450,  6478242,
-    6514033,  6549825,  6585616,  6621407,  6657199,  6692990,  6728782,
-    6764573,  6800364,  6836156,  6871947,  6907739,  6943530,  6979321,
-    7015113,  7050904,  7086696,  7122487,  7158278,  7194070,  7229861,
-    7265653,  7301444,  7337235,  7373027,  7408818,  7444609,  7480401,
-    7516192,  7551984,  7587775,  7623566,  7659358,  7695149,  7730941,
-    7766732,  7802523,  7838315,  7874106,  7909898,  7945689,  7981480,
-    8017272,  8053063,  8088855,  8124646,  8160437,  8196229,  8232020,
-    8267812,  8303603,  8339394,  8375186,  8410977,  8446769,  8482560,
-    8518351,  8554143,  8589934,  8625725,  8661517,  8697308,  8733100,
-    8768891,  8804682,  8840474,  8876265,  8912057,  8947848,  8983639,
-    9019431,  9055222,  9091014,  9126805,  9162596,  9198388,  9234179,
-    9269971,  9305762,  9341553,  9377345,  9413136,  9448928,  9484719,
-    9520510,  9556302,  9592093,  9627885,  9663676,  9699467,  9735259,
-    9771050,  9806841,  9842633,  9878424,  9914216,  9950007,  9985798,
-    10021590, 10057381, 10093173, 10128964, 10164755, 10200547, 10236338,
-    10272130, 10307921, 10343712, 10379504, 10415295, 10451087, 10486878,
-    10522669, 10558461, 10594252, 10630044, 10665835, 10701626, 10737418,
-    10773209, 10809001, 10844792, 10880583, 10916375, 10952166, 10987957,
-    11023749, 11059540, 11095332, 11131123, 11166914, 11202706, 11238497,
-    11274289, 11310080, 11345871, 11381663, 11417454, 11453246, 11489037,
-    11524828, 11560620, 11596411, 11632203, 11667994, 11703785, 11739577,
-    11775368, 11811160, 11846951, 11882742, 11918534, 11954325, 11990117,
-    12025908, 12061699, 12097491, 12133282, 12169074, 12204865, 12240656,
-    12276448, 12312239, 12348030, 12383822, 12419613, 12455405, 12491196,
-    12526987, 12562779, 12598570, 12634362, 12670153, 12705944, 12741736,
-    12777527, 12813319, 12849110, 12884901, 12920693, 12956484, 12992276,
-    13028067, 13063858, 13099650, 13135441, 13171233, 13207024, 13242815,
-    13278607, 13314398, 13350190, 13385981, 13421772, 13457564, 13493355,
-    13529146, 13564938, 13600729, 13636521, 13672312, 13708103, 13743895,
-    13779686, 13815478, 13851269, 13887060, 13922852, 13958643, 13994435,
-    14030226, 14066017, 14101809, 14137600, 14173392, 14209183, 14244974,
-    14280766, 14316557, 14352349, 14388140, 14423931, 14459723, 14495514,
-    14531306, 14567097, 14602888, 14638680, 14674471, 14710262, 14746054,
-    14781845, 14817637, 14853428, 14889219, 14925011, 14960802, 14996594,
-    15032385, 15068176, 15103968, 15139759, 15175551, 15211342, 15247133,
-    15282925, 15318716, 15354508, 15390299, 15426090, 15461882, 15497673,
-    15533465, 15569256, 15605047, 15640839, 15676630, 15712422, 15748213,
-    15784004, 15819796, 15855587, 15891378, 15927170, 15962961, 15998753,
-    16034544, 16070335, 16106127, 16141918, 16177710, 16213501, 16249292,
-    16285084, 16320875, 16356667, 16392458, 16428249, 16464041, 16499832,
-    16535624, 16571415, 16607206, 16642998, 16678789, 16714581, 16750372,
-    16786163, 16821955, 16857746, 16893538, 16929329, 16965120, 17000912,
-    17036703, 17072495, 17108286, 17144077, 17179869, 17215660, 17251451,
-    17287243, 17323034, 17358826, 17394617, 17430408, 17466200, 17501991,
-    17537783, 17573574, 17609365, 17645157, 17680948, 17716740, 17752531,
-    17788322, 17824114, 17859905, 17895697, 17931488, 17967279, 18003071,
-    18038862, 18074654, 18110445, 18146236, 18182028, 18217819, 18253611,
-    18289402,
-};
-const uint8_t lut_res_gauss_curve[] PROGMEM = {
-    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
-    1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,
-    3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,
-    6,   6,   6,   7,   7,   7,   8,   8,   8,   9,   9,   9,   10,  10,  10,
-    11,  11,  12,  12,  12,  13,  13,  14,  14,  15,  15,  16,  16,  17,  18,
-    18,  19,  19,  20,  21,  21,  22,  23,  24,  24,  25,  26,  27,  28,  28,
-    29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  43,  44,
-    45,  46,  47,  49,  50,  51,  53,  54,  55,  57,  58,  60,  61,  63,  64,
-    66,  67,  69,  70,  72,  74,  75,  77,  79,  81,  82,  84,  86,  88,  90,
-    91,  93,  95,  97,  99,  101, 103, 105, 107, 109, 111, 113, 115, 117, 119,
-    121, 124, 126, 128, 130, 132, 134, 137, 139, 141, 143, 145, 148, 150, 152,
-    154, 156, 159, 161, 163, 165, 167, 170, 172, 174, 176, 178, 180, 183, 185,
-    187, 189, 191, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 212, 214,
-    216, 218, 220, 221, 223, 225, 226, 228, 229, 231, 232, 234, 235, 236, 238,
-    239, 240, 241, 242, 243, 244, 245, 246, 247, 248, 249, 249, 250, 251, 251,
-    252, 252, 253, 253, 254, 254, 254, 254, 254, 254, 255, 254, 254, 254, 254,
-    254, 254, 253, 253, 252, 252, 251, 251, 250, 249, 249, 248, 247, 246, 245,
-    244, 243, 242, 241, 240, 239, 238, 236, 235, 234, 232, 231, 229, 228, 226,
-    225, 223, 221, 220, 218, 216, 214, 212, 211, 209, 207, 205, 203, 201, 199,
-    197, 195, 193, 191, 189, 187, 185, 183, 180, 178, 176, 174, 172, 170, 167,
-    165, 163, 161, 159, 156, 154, 152, 150, 148, 145, 143, 141, 139, 137, 134,
-    132, 130, 128, 126, 124, 121, 119, 117, 115, 113, 111, 109, 107, 105, 103,
-    101, 99,  97,  95,  93,  91,  90,  88,  86,  84,  82,  81,  79,  77,  75,
-    74,  72,  70,  69,  67,  66,  64,  63,  61,  60,  58,  57,  55,  54,  53,
-    51,  50,  49,  47,  46,  45,  44,  43,  41,  40,  39,  38,  37,  36,  35,
-    34,  33,  32,  31,  30,  29,  28,  28,  27,  26,  25,  24,  24,  23,  22,
-    21,  21,  20,  19,  19,  18,  18,  17,  16,  16,  15,  15,  14,  14,  13,
-    13,  12,  12,  12,  11,  11,  10,  10,  10,  9,   9,   9,   8,   8,   8,
-    7,   7,   7,   6,   6,   6,   6,   5,   5,   5,   5,   5,   4,   4,   4,
-    4,   4,   3,   3,   3,   3,   3,   3,   3,   2,   2,   2,   2,   2,   2,
-    2,   2,   2,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
-    1,   1,   1,   1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   0,   0,   0};
-
-const uint32_t lut_res_legacy_timer_lin[] PROGMEM = {
-    3062500, 3050530, 3038560, 3026591, 3014621, 3002651, 2990681, 2978711,
-    2966742, 2954772, 2942802, 2930832, 2918862, 2906893, 2894923, 2882953,
-    2870983, 2859013, 2847044, 2835074, 2823104, 2811134, 2799164, 2787195,
-    2775225, 2763255, 2751285, 2739315, 2727345, 2715376, 2703406, 2691436,
-    2679466, 2667496, 2655527, 2643557, 2631587, 2619617, 2607647, 2595678,
-    2583708, 2571738, 2559768, 2547798, 2535829, 2523859, 2511889, 2499919,
-    2487949, 2475980, 2464010, 2452040, 2440070, 2428100, 2416131, 2404161,
-    2392191, 2380221, 2368251, 2356282, 2344312, 2332342, 2320372, 2308402,
-    2296433, 2284463, 2272493, 2260523, 2248553, 2236584, 2224614, 2212644,
-    2200674, 2188704, 2176735, 2164765, 2152795, 2140825, 2128855, 2116885,
-    2104916, 2092946, 2080976, 2069006, 2057036, 2045067, 2033097, 2021127,
-    2009157, 1997187, 1985218, 1973248, 1961278, 1949308, 1937338, 1925369,
-    1913399, 1901429, 1889459, 1877489, 1865520, 1853550, 1841580, 1829610,
-    1817640, 1805671, 1793701, 1781731, 1769761, 1757791, 1745822, 1733852,
-    1721882, 1709912, 1697942, 1685973, 1674003, 1662033, 1650063, 1638093,
-    1626124, 1614154, 1602184, 1590214, 1578244, 1566275, 1554305, 1542335,
-    1530365, 1518395, 1506425, 1494456, 1482486, 1470516, 1458546, 1446576,
-    1434607, 1422637, 1410667, 1398697, 1386727, 1374758, 1362788, 1350818,
-    1338848, 1326878, 1314909, 1302939, 1290969, 1278999, 1267029, 1255060,
-    1243090, 1231120, 1219150, 1207180, 1195211, 1183241, 1171271, 1159301,
-    1147331, 1135362, 1123392, 1111422, 1099452, 1087482, 1075513, 1063543,
-    1051573, 1039603, 1027633, 1015664, 1003694, 991724,  979754,  967784,
-    955815,  943845,  931875,  919905,  907935,  895965,  883996,  872026,
-    860056,  848086,  836116,  824147,  812177,  800207,  788237,  776267,
-    764298,  752328,  740358,  728388,  716418,  704449,  692479,  680509,
-    668539,  656569,  644600,  632630,  620660,  608690,  596720,  584751,
-    572781,  560811,  548841,  536871,  524902,  512932,  500962,  488992,
-    477022,  465053,  453083,  441113,  429143,  417173,  405204,  393234,
-    381264,  369294,  357324,  345355,  333385,  321415,  309445,  297475,
-    285505,  273536,  261566,  249596,  237626,  225656,  213687,  201717,
-    189747,  177777,  165807,  153838,  141868,  129898,  117928,  105958,
-    93989,   82019,   70049,   58079,   46109,   34140,   22170,   10200};
-
-const uint32_t lut_res_legacy_timer_log[] PROGMEM = {
-    3062500, 3009698, 2957798, 2906785, 2856644, 2807359, 2758916, 2711301,
-    2664500, 2618498, 2573282, 2528839, 2485154, 2442217, 2400013, 2358530,
-    2317755, 2277678, 2238285, 2199565, 2161507, 2124099, 2087330, 2051189,
-    2015666, 1980750, 1946430, 1912697, 1879540, 1846949, 1814916, 1783429,
-    1752481, 1722062, 1692162, 1662773, 1633886, 1605492, 1577584, 1550153,
-    1523190, 1496688, 1470639, 1445035, 1419868, 1395131, 1370817, 1346918,
-    1323428, 1300339, 1277644, 1255338, 1233412, 1211861, 1190678, 1169857,
-    1149392, 1129276, 1109504, 1090070, 1070968, 1052193, 1033738, 1015598,
-    997769,  980244,  963018,  946087,  929445,  913087,  897009,  881206,
-    865672,  850404,  835397,  820646,  806148,  791897,  777889,  764121,
-    750588,  737286,  724212,  711361,  698729,  686313,  674110,  662115,
-    650324,  638736,  627345,  616149,  605144,  594327,  583695,  573245,
-    562973,  552877,  542953,  533199,  523611,  514188,  504925,  495820,
-    486871,  478075,  469430,  460932,  452579,  444369,  436299,  428367,
-    420570,  412907,  405375,  397971,  390694,  383541,  376511,  369600,
-    362808,  356131,  349569,  343119,  336779,  330547,  324422,  318402,
-    312484,  306667,  300950,  295331,  289807,  284378,  279042,  273797,
-    268641,  263574,  258593,  253697,  248885,  244155,  239506,  234936,
-    230444,  226030,  221690,  217425,  213232,  209112,  205061,  201080,
-    197167,  193321,  189540,  185824,  182172,  178582,  175053,  171584,
-    168175,  164824,  161530,  158293,  155111,  151983,  148909,  145887,
-    142917,  139997,  137128,  134307,  131535,  128810,  126132,  123499,
-    120912,  118368,  115868,  113411,  110996,  108622,  106288,  103994,
-    101740,  99524,   97346,   95205,   93101,   91033,   89000,   87002,
-    85038,   83107,   81210,   79344,   77511,   75709,   73938,   72197,
-    70486,   68804,   67151,   65526,   63929,   62359,   60816,   59299,
-    57809,   56343,   54903,   53488,   52096,   50728,   49384,   48063,
-    46764,   45487,   44233,   42999,   41787,   40595,   39424,   38273,
-    37141,   36029,   34936,   33862,   32805,   31767,   30747,   29744,
-    28758,   27789,   26837,   25901,   24981,   24076,   23187,   22314,
-    21455,   20611,   19781,   18965,   18164,   17376,   16601,   15840,
-    15092,   14356,   13633,   12923,   12224,   11538,   10863,   10200};
-} // namespace clkr
\ No newline at end of file
+// Copyright 2012 Emilie Gillet, 2023 Katherine Whitlock
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//         Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Resources definitions, filled in at compile time.
+
+#include "resources.h"
+
+namespace clkr {
+const lut::Table<uint32_t, kLegacyKnots>
+    lut_res_legacy_knots[LEGACY_CURVE_LAST] PROGMEM = {
+        lut::MakeTable<LegacyKnotsLin>(),
+        lut::MakeTable<LegacyKnotsLog>(),
+        lut::MakeTable<LegacyKnotsExp>(),
+};
+} // namespace clkr
@@ -0,0 +1,156 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Settings journal, spread over the whole EEPROM.
+
+#include "settings_journal.h"
+
+namespace clkr {
+
+/* static */
+uint8_t SettingsJournal::slot_;
+
+/* static */
+uint16_t SettingsJournal::sequence_;
+
+/* static */
+Settings SettingsJournal::settings_;
+
+/* static */
+bool SettingsJournal::pending_;
+
+/* static */
+bool SettingsJournal::committing_;
+
+/* static */
+uint8_t SettingsJournal::record_[kRecordSize];
+
+static inline uint16_t ReadWord(const uint8_t *bytes) {
+  return bytes[0] | static_cast<uint16_t>(bytes[1]) << 8;
+}
+
+/* static */
+uint16_t SettingsJournal::Crc(const uint8_t *record) {
+  // CRC-16/CCITT, reflected, as _crc_ccitt_update from avr-libc
+  uint16_t crc = 0xffff;
+  for (uint8_t i = 0; i < RECORD_CRC; ++i) {
+    crc ^= record[i];
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = crc & 1 ? (crc >> 1) ^ 0x8408 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+/* static */
+bool SettingsJournal::Load(Settings *settings) {
+  bool found = false;
+  uint8_t record[kRecordSize];
+  // Without a record the first save goes after slot 0, which holds the
+  // legacy settings
+  slot_ = 0;
+  sequence_ = 0;
+  for (uint8_t slot = 0; slot < kNumSlots; ++slot) {
+    uint16_t address = slot * kRecordSize;
+    for (uint8_t i = 0; i < kRecordSize; ++i) {
+      record[i] = hal::Eeprom::Read(address + i);
+    }
+    if (record[RECORD_VERSION] != kVersion ||
+        ReadWord(record + RECORD_CRC) != Crc(record)) {
+      continue;
+    }
+    uint16_t sequence = ReadWord(record + RECORD_SEQUENCE);
+    // Live records are never more than kNumSlots apart, so this holds
+    // across the sequence number wrapping round
+    if (found && static_cast<int16_t>(sequence - sequence_) <= 0) {
+      continue;
+    }
+    found = true;
+    slot_ = slot;
+    sequence_ = sequence;
+    settings->options = record[RECORD_OPTIONS];
+    settings->tempo = ReadWord(record + RECORD_TEMPO);
+    settings->restart = record[RECORD_RESTART];
+  }
+  return found;
+}
+
+/* static */
+void SettingsJournal::Save(const Settings &settings) {
+  settings_ = settings;
+  pending_ = true;
+  Poll();
+}
+
+/* static */
+void SettingsJournal::Poll() {
+  if (!EepromWriter::idle()) {
+    return;
+  }
+  uint16_t address = slot_ * kRecordSize;
+  if (committing_) {
+    committing_ = false;
+    WriteRecord(address);
+    return;
+  }
+  if (!pending_) {
+    return;
+  }
+  pending_ = false;
+  slot_ = slot_ + 1 < kNumSlots ? slot_ + 1 : 0;
+  ++sequence_;
+
+  record_[RECORD_VERSION] = kVersion;
+  record_[RECORD_SEQUENCE] = sequence_;
+  record_[RECORD_SEQUENCE + 1] = sequence_ >> 8;
+  record_[RECORD_OPTIONS] = settings_.options;
+  record_[RECORD_TEMPO] = settings_.tempo;
+  record_[RECORD_TEMPO + 1] = settings_.tempo >> 8;
+  record_[RECORD_RESTART] = settings_.restart;
+  for (uint8_t i = RECORD_RESTART + 1; i < RECORD_CRC; ++i) {
+    record_[i] = 0xff;
+  }
+  uint16_t crc = Crc(record_);
+  record_[RECORD_CRC] = crc;
+  record_[RECORD_CRC + 1] = crc >> 8;
+
+  // Clear the version of the record being replaced first. Until the new
+  // one is complete the slot is then invalid for certain, rather than a mix
+  // of old and new bytes that the CRC only catches most of the time. A slot
+  // that is invalid already is left as it is: its version may have been
+  // torn by a power loss during an earlier save, and clearing it could just
+  // as well tear it back to valid, over a complete record newer than the
+  // one Load() found.
+  address = slot_ * kRecordSize;
+  if (hal::Eeprom::Read(address + RECORD_VERSION) == kVersion) {
+    EepromWriter::Write(address + RECORD_VERSION, 0);
+    committing_ = true;
+    return;
+  }
+  WriteRecord(address);
+}
+
+/* static */
+void SettingsJournal::WriteRecord(uint16_t address) {
+  // The old record is gone, write the new one with its version last
+  for (uint8_t i = RECORD_VERSION + 1; i < kRecordSize; ++i) {
+    EepromWriter::Write(address + i, record_[i]);
+  }
+  EepromWriter::Write(address + RECORD_VERSION, kVersion);
+}
+
+} // namespace clkr
@@ -0,0 +1,178 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// External clock sync.
+
+#include "sync_pll.h"
+
+namespace clkr {
+
+/* static */
+uint32_t SyncPll::last_edge_;
+
+/* static */
+uint32_t SyncPll::timeout_;
+
+/* static */
+bool SyncPll::measuring_;
+
+/* static */
+bool SyncPll::active_;
+
+/* static */
+uint8_t SyncPll::lock_count_;
+
+/* static */
+int32_t SyncPll::error_;
+
+/* static */
+uint32_t SyncPll::beat_start_;
+
+/* static */
+uint8_t SyncPll::beat_fraction_;
+
+/* static */
+uint32_t SyncPll::period_;
+
+/* static */
+uint32_t SyncPll::step_;
+
+/* static */
+uint8_t SyncPll::position_;
+
+/* static */
+uint32_t SyncPll::last_target_;
+
+/* static */
+void SyncPll::Init() {
+  hal::InterruptLock lock;
+  measuring_ = false;
+  active_ = false;
+  lock_count_ = 0;
+}
+
+/* static */
+bool SyncPll::Edge(uint32_t time) {
+  uint32_t elapsed = time - last_edge_;
+  last_edge_ = time;
+
+  if (!active_) {
+    // Wait for two edges in a row within range to get a first period
+    bool acquired = measuring_ && elapsed >= kMinimumPeriod &&
+                    elapsed <= kMaximumPeriod;
+    measuring_ = true;
+    if (!acquired) {
+      return false;
+    }
+    period_ = elapsed << 4;
+    step_ = period_ / kHalfPulsesPerInput;
+    beat_start_ = time;
+    beat_fraction_ = 0;
+    position_ = 0;
+    last_target_ = time;
+    timeout_ = elapsed << 1;
+    error_ = 0;
+    lock_count_ = 0;
+    active_ = true;
+    return true;
+  }
+
+  // Phase error against the nearest beat of the oscillator. The output may
+  // already be scheduled a beat or two ahead (SLOW mode), so fold it into
+  // half a period either side.
+  int32_t length = period_ >> 4;
+  int32_t error = time - beat_start_;
+  while (error > (length >> 1)) {
+    error -= length;
+  }
+  while (error < -(length >> 1)) {
+    error += length;
+  }
+  error_ = error;
+
+  // Proportional part on the phase, integral part on the period. Until
+  // locked, pull the period most of the way to the measured one as well,
+  // so a change of tempo is picked up in a couple of input periods.
+  beat_start_ += error >> kPhaseShift;
+  int32_t period = period_ + ((error << 4) >> kFrequencyShift);
+  if (!locked() && elapsed >= kMinimumPeriod && elapsed <= kMaximumPeriod) {
+    period += ((static_cast<int32_t>(elapsed << 4) - period) >> 1);
+  }
+  if (period < static_cast<int32_t>(kMinimumPeriod << 4)) {
+    period = kMinimumPeriod << 4;
+  } else if (period > static_cast<int32_t>(kMaximumPeriod << 4)) {
+    period = kMaximumPeriod << 4;
+  }
+  period_ = period;
+  step_ = period_ / kHalfPulsesPerInput;
+  timeout_ = (period_ >> 4) << 1;
+
+  if (error < 0) {
+    error = -error;
+  }
+  if (error < (length >> kLockShift)) {
+    if (lock_count_ < kLockCount) {
+      ++lock_count_;
+    }
+  } else {
+    lock_count_ = 0;
+  }
+  return false;
+}
+
+/* static */
+void SyncPll::Align(uint16_t first_edge) {
+  last_target_ = Timebase::now() +
+                 static_cast<uint16_t>(first_edge - hal::TickTimer::now());
+}
+
+/* static */
+uint32_t SyncPll::NextEdgeInterval(uint8_t num_half_pulses,
+                                   uint32_t minimum_interval) {
+  position_ += num_half_pulses;
+  while (position_ >= kHalfPulsesPerInput) {
+    position_ -= kHalfPulsesPerInput;
+    uint32_t length = period_ + beat_fraction_;
+    beat_start_ += length >> 4;
+    beat_fraction_ = length & 0x0f;
+  }
+  uint32_t target = beat_start_ + ((step_ * position_) >> 4);
+
+  // A phase correction may pull the target back behind the previous edge,
+  // or too close to it to be scheduled. Catch up as soon as possible then.
+  uint32_t interval = target - last_target_;
+  if (static_cast<int32_t>(interval) < static_cast<int32_t>(minimum_interval)) {
+    interval = minimum_interval;
+  }
+  last_target_ += interval;
+  return interval;
+}
+
+/* static */
+uint16_t SyncPll::tempo() {
+  uint32_t period;
+  {
+    hal::InterruptLock lock;
+    period = period_ >> 4;
+  }
+  const uint32_t kBeatCyclesPerBpm = F_CPU * 60L / kInputPpqn;
+  uint32_t bpm = kBeatCyclesPerBpm / period;
+  uint32_t remainder = kBeatCyclesPerBpm % period;
+  return (bpm << kTempoFractionalBits) +
+         (remainder << kTempoFractionalBits) / period;
+}
+
+} // namespace clkr
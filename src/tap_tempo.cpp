@@ -0,0 +1,102 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+// Tap tempo estimator.
+
+#include "tap_tempo.h"
+
+namespace clkr {
+
+/* static */
+bool TapTempo::started_;
+
+/* static */
+uint32_t TapTempo::last_tap_;
+
+/* static */
+uint32_t TapTempo::intervals_[kNumIntervals];
+
+/* static */
+uint8_t TapTempo::head_;
+
+/* static */
+uint8_t TapTempo::num_intervals_;
+
+/* static */
+TapTempoResult TapTempo::Tap(uint32_t time, uint16_t *tempo) {
+  uint32_t since_tap = time - last_tap_;
+  if (started_ && since_tap < kMinimumInterval) {
+    return TAP_TEMPO_NONE;
+  }
+  last_tap_ = time;
+  if (!started_ || since_tap >= kMaximumInterval) {
+    started_ = true;
+    head_ = 0;
+    num_intervals_ = 0;
+    return TAP_TEMPO_UNLOCK;
+  }
+  intervals_[head_] = since_tap;
+  head_ = head_ + 1 < kNumIntervals ? head_ + 1 : 0;
+  if (num_intervals_ < kNumIntervals) {
+    ++num_intervals_;
+  }
+
+  uint32_t intervals[kNumIntervals];
+  uint8_t num_intervals = num_intervals_;
+  for (uint8_t i = 0; i < num_intervals; ++i) {
+    intervals[i] = intervals_[i];
+  }
+
+  // Insertion sort, there are only a handful of them
+  for (uint8_t i = 1; i < num_intervals; ++i) {
+    uint32_t interval = intervals[i];
+    uint8_t j = i;
+    for (; j > 0 && intervals[j - 1] > interval; --j) {
+      intervals[j] = intervals[j - 1];
+    }
+    intervals[j] = interval;
+  }
+  uint8_t middle = num_intervals >> 1;
+  uint32_t median = intervals[middle];
+  if (!(num_intervals & 1)) {
+    median = (median + intervals[middle - 1]) >> 1;
+  }
+
+  // Average whatever is close enough to the median
+  uint32_t tolerance = median >> 2;
+  uint32_t sum = 0;
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < num_intervals; ++i) {
+    if (intervals[i] + tolerance >= median &&
+        intervals[i] <= median + tolerance) {
+      sum += intervals[i];
+      ++count;
+    }
+  }
+  if (!count) {
+    sum = median;
+    count = 1;
+  }
+
+  // Timer1 counts per beat (seven intervals stay below 2^29), then the
+  // tempo, with both sides divided by 16 to keep it within 32 bits
+  uint32_t interval = sum / count;
+  *tempo = (BpmToTempo(60) * (Timebase::kCountsPerSecond >> 4)) /
+           (interval >> 4);
+  return TAP_TEMPO_UPDATE;
+}
+
+} // namespace clkr
@@ -0,0 +1,38 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Monotonic timebase.
+
+#include "timebase.h"
+
+namespace clkr {
+
+/* static */
+uint32_t Timebase::time_;
+
+/* static */
+uint32_t Timebase::ticks_;
+
+/* static */
+void Timebase::Init(uint16_t tick_period) {
+  hal::InterruptLock lock;
+  // The low half of the time at the last tick is the count it matched at
+  time_ = static_cast<uint16_t>(hal::TickTimer::compare() - tick_period);
+  ticks_ = 0;
+}
+
+} // namespace clkr
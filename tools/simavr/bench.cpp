@@ -0,0 +1,296 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// ISR cycle budget benchmark. Boots the clkr_bench firmware in simavr once per
+// operating mode, drives scripted pot, CV and button input, and reports the
+// min/avg/max cycles of every interrupt handler and benchmark section along
+// with the overall interrupt load, as JSON on stdout. With -s it plays a
+// script onto the inputs of any firmware instead, see script.h.
+//
+//   pio run -e clkr_bench && pio run -e simavr
+//   .pio/build/simavr/program .pio/build/clkr_bench/firmware.elf > bench.json
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "script.h"
+
+#include "clock.h"
+#include "hardware_config.h"
+
+namespace clkr {
+
+static const char *const section_names[BENCH_LAST] = {
+    "HandleTapButton",  "HandleClockInternalGrids", "UpdateClockOut",
+    "ScheduleNextEdge", "UpdateLeds",               "ScanPots",
+    "SyncPll",
+};
+
+static const char *const profiled_names[PROFILE_LAST] = {
+    "TIMER1_COMPA", "TIMER1_COMPB", "PCINT1"};
+
+// The analog inputs, button and Pause CV jack at a given time into the run
+struct Inputs {
+  uint8_t pot;
+  uint8_t cv;
+  bool button;
+  bool pause_cv;
+};
+
+typedef void (*Stimulus)(double t, double duration, Inputs *inputs);
+
+struct Mode {
+  const char *name;
+  Options options;
+  bool slow;
+  Stimulus stimulus;
+};
+
+// Triangle sweep of the pot over the whole run, a CV step in the middle and
+// a couple of presses of the pause button.
+static void SweepAndPause(double t, double duration, Inputs *inputs) {
+  double x = t / duration * 2.0;
+  inputs->pot = static_cast<uint8_t>(255.0 * (x < 1.0 ? x : 2.0 - x));
+  inputs->cv = (t > duration * 0.25 && t < duration * 0.5) ? 0 : 255;
+  inputs->button = (t > duration * 0.6 && t < duration * 0.62) ||
+                   (t > duration * 0.7 && t < duration * 0.72);
+  inputs->pause_cv = false;
+}
+
+// Steady pot, tapping at 125 BPM
+static void Tapping(double t, double duration, Inputs *inputs) {
+  inputs->pot = 128;
+  inputs->cv = 255;
+  double phase = t / 0.48;
+  inputs->button = t > 0.5 && phase - static_cast<int>(phase) < 0.1;
+  inputs->pause_cv = false;
+}
+
+// Long press into the settings menu, wait in it, then turn the pot
+// through every resolution.
+static void SettingsMenu(double t, double duration, Inputs *inputs) {
+  inputs->cv = 255;
+  inputs->button = t > 0.2 && t < 1.7;
+  inputs->pause_cv = false;
+  inputs->pot = 128;
+  if (t > duration * 0.7) {
+    double x = (t - duration * 0.7) / (duration * 0.3);
+    inputs->pot = static_cast<uint8_t>(255.0 * x);
+  }
+}
+
+// A 4 PPQN master clock on the Pause CV jack, speeding up from 120 to 132
+// BPM half way. Firmware built with CLKR_SYNC locks on to it, otherwise it
+// just gates the output.
+static void SyncInput(double t, double duration, Inputs *inputs) {
+  inputs->pot = 128;
+  inputs->cv = 255;
+  inputs->button = false;
+  double half = duration * 0.5;
+  double phase = t < half ? t * 8.0 : half * 8.0 + (t - half) * 8.8;
+  inputs->pause_cv = phase - static_cast<int>(phase) < 0.5;
+}
+
+static const Mode modes[] = {
+    {"grids_4ppqn", {CLOCK_RESOLUTION_4_PPQN, false, false, false}, false,
+     &SweepAndPause},
+    {"grids_8ppqn", {CLOCK_RESOLUTION_8_PPQN, false, false, false}, false,
+     &SweepAndPause},
+    {"grids_24ppqn", {CLOCK_RESOLUTION_24_PPQN, false, false, false}, false,
+     &SweepAndPause},
+    {"grids_48ppqn", {CLOCK_RESOLUTION_48_PPQN, false, false, false}, false,
+     &SweepAndPause},
+    {"grids_96ppqn", {CLOCK_RESOLUTION_96_PPQN, false, false, false}, false,
+     &SweepAndPause},
+    {"grids_24ppqn_slow", {CLOCK_RESOLUTION_24_PPQN, false, false, false},
+     true, &SweepAndPause},
+    {"grids_tap_tempo", {CLOCK_RESOLUTION_24_PPQN, true, false, false}, false,
+     &Tapping},
+    {"legacy_lin_fast",
+     {CLOCK_RESOLUTION_24_PPQN, false, false, true, LEGACY_CURVE_LINEAR},
+     false, &SweepAndPause},
+    {"legacy_lin_slow",
+     {CLOCK_RESOLUTION_24_PPQN, false, false, true, LEGACY_CURVE_LINEAR},
+     true, &SweepAndPause},
+    {"legacy_log_fast",
+     {CLOCK_RESOLUTION_24_PPQN, true, false, true, LEGACY_CURVE_LOG}, false,
+     &SweepAndPause},
+    {"legacy_log_slow",
+     {CLOCK_RESOLUTION_24_PPQN, true, false, true, LEGACY_CURVE_LOG}, true,
+     &SweepAndPause},
+    {"legacy_exp_fast",
+     {CLOCK_RESOLUTION_24_PPQN, false, false, true, LEGACY_CURVE_EXP}, false,
+     &SweepAndPause},
+    {"settings_menu", {CLOCK_RESOLUTION_24_PPQN, false, false, false}, false,
+     &SettingsMenu},
+    {"grids_sync", {CLOCK_RESOLUTION_24_PPQN, false, false, false}, false,
+     &SyncInput},
+};
+
+static void PrintStats(const char *name, const CycleStats &stats,
+                       bool *first) {
+  if (!stats.count) {
+    return;
+  }
+  printf("%s\n        \"%s\": {\"count\": %u, \"min\": %u, \"avg\": %.1f, "
+         "\"max\": %u}",
+         *first ? "" : ",", name, stats.count, stats.min, stats.average(),
+         stats.max);
+  *first = false;
+}
+
+static bool RunMode(const char *elf_path, const Mode &mode, double duration,
+                    bool first_mode) {
+  Harness harness;
+  if (!harness.Load(elf_path)) {
+    return false;
+  }
+
+  uint8_t eeprom[2] = {mode.options.pack(), 120};
+  harness.SetEeprom(eeprom, sizeof(eeprom));
+  harness.SetAdc(ADC_CHANNEL_SELECTOR, mode.slow ? 255 : 0);
+  harness.SetPin('C', 3, true); // Pause CV at 0V
+  harness.SetPin('B', 4, false);
+
+  // Let the firmware boot before measuring
+  uint64_t millisecond = harness.frequency() / 1000;
+  harness.Run(millisecond * 10);
+  harness.ResetStats();
+
+  Inputs inputs;
+  uint32_t steps = static_cast<uint32_t>(duration * 1000);
+  for (uint32_t i = 0; i < steps; ++i) {
+    mode.stimulus(i / 1000.0, duration, &inputs);
+    harness.SetAdc(ADC_CHANNEL_TEMPO, inputs.pot);
+    harness.SetAdc(ADC_CHANNEL_TEMPO_CV, inputs.cv);
+    harness.SetPin('B', 4, inputs.button);
+    harness.SetPin('C', 3, !inputs.pause_cv); // inverting input
+    if (!harness.Run(millisecond)) {
+      fprintf(stderr, "%s: core stopped at cycle %llu\n", mode.name,
+              static_cast<unsigned long long>(harness.cycle()));
+      return false;
+    }
+  }
+
+  double load = static_cast<double>(harness.busy_cycles()) /
+                harness.elapsed_cycles();
+  printf("%s\n    {\n      \"mode\": \"%s\",\n      \"cycles\": %llu,\n"
+         "      \"cpu_load\": %.4f,\n      \"isr\": {",
+         first_mode ? "" : ",", mode.name,
+         static_cast<unsigned long long>(harness.elapsed_cycles()), load);
+  bool first = true;
+  for (uint8_t i = 0; i < kNumVectors; ++i) {
+    PrintStats(Harness::vector_name(i), harness.isr(i), &first);
+  }
+  printf("\n      },\n      \"sections\": {");
+  first = true;
+  for (uint8_t i = 0; i < BENCH_LAST; ++i) {
+    PrintStats(section_names[i], harness.section(i), &first);
+  }
+  printf("\n      }");
+  IsrProfile profile[PROFILE_LAST];
+  if (harness.ReadProfile(profile)) {
+    // The firmware's own view, from a clkr_profile build
+    printf(",\n      \"profile\": {");
+    for (uint8_t i = 0; i < PROFILE_LAST; ++i) {
+      const IsrProfile &isr = profile[i];
+      printf("%s\n        \"%s\": {\"count\": %u, \"min\": %u, "
+             "\"avg\": %.1f, \"max\": %u, \"max_latency\": %u, "
+             "\"overruns\": %u}",
+             i ? "," : "", profiled_names[i], isr.count,
+             isr.count ? isr.min : 0,
+             isr.count ? static_cast<double>(isr.total) / isr.count : 0.0,
+             isr.max, isr.max_latency, isr.overruns);
+    }
+    printf("\n      }");
+  }
+  printf("\n    }");
+
+  fprintf(stderr, "%-20s load %5.2f%%", mode.name, load * 100.0);
+  for (uint8_t i = 0; i < kNumVectors; ++i) {
+    const CycleStats &stats = harness.isr(i);
+    if (stats.count) {
+      fprintf(stderr, "  %s %u/%.0f/%u", Harness::vector_name(i), stats.min,
+              stats.average(), stats.max);
+    }
+  }
+  fprintf(stderr, "\n");
+  return true;
+}
+
+} // namespace clkr
+
+int main(int argc, char **argv) {
+  double duration = 4.0;
+  const char *only = NULL;
+  const char *script = NULL;
+  const char *vcd = NULL;
+  bool print_edges = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "t:m:s:v:e")) != -1) {
+    switch (opt) {
+    case 't':
+      duration = atof(optarg);
+      break;
+    case 'm':
+      only = optarg;
+      break;
+    case 's':
+      script = optarg;
+      break;
+    case 'v':
+      vcd = optarg;
+      break;
+    case 'e':
+      print_edges = true;
+      break;
+    default:
+      optind = argc;
+      break;
+    }
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr,
+            "usage: %s [-t seconds] [-m mode] firmware.elf\n"
+            "       %s -s script [-v trace.vcd] [-e] firmware.elf\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  // Play a script instead, see script.h
+  if (script) {
+    return clkr::RunScript(argv[optind], script, vcd, print_edges) ? 0 : 1;
+  }
+
+  printf("{\n  \"firmware\": \"%s\",\n  \"seconds\": %.1f,\n  \"modes\": [",
+         argv[optind], duration);
+  bool first = true;
+  bool ok = true;
+  for (const clkr::Mode &mode : clkr::modes) {
+    if (only && strcmp(only, mode.name)) {
+      continue;
+    }
+    ok = clkr::RunMode(argv[optind], mode, duration, first) && ok;
+    first = false;
+  }
+  printf("\n  ]\n}\n");
+  return ok ? 0 : 1;
+}
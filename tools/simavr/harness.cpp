@@ -0,0 +1,218 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// simavr harness implementation.
+
+#include "harness.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <simavr/avr_adc.h>
+#include <simavr/avr_eeprom.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_timer.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+
+namespace clkr {
+
+// Data space addresses of the registers written by BENCH_BEGIN/BENCH_END
+const avr_io_addr_t kGpior0 = 0x3e;
+const avr_io_addr_t kGpior1 = 0x4a;
+
+// PORTB, PORTC and PORTD, and the Timer0 registers that drive the LED pins
+const avr_io_addr_t kPortB = 0x25;
+const avr_io_addr_t kTccr0a = 0x44;
+const avr_io_addr_t kOcr0a = 0x47;
+const avr_io_addr_t kOcr0b = 0x48;
+
+const uint16_t kOpcodeReti = 0x9518;
+
+// Each ATmega328P vector is a two word JMP
+const uint8_t kVectorSize = 4;
+
+static const char *const vector_names[kNumVectors] = {
+    "RESET",        "INT0",         "INT1",        "PCINT0",
+    "PCINT1",       "PCINT2",       "WDT",         "TIMER2_COMPA",
+    "TIMER2_COMPB", "TIMER2_OVF",   "TIMER1_CAPT", "TIMER1_COMPA",
+    "TIMER1_COMPB", "TIMER1_OVF",   "TIMER0_COMPA", "TIMER0_COMPB",
+    "TIMER0_OVF",   "SPI_STC",      "USART_RX",    "USART_UDRE",
+    "USART_TX",     "ADC",          "EE_READY",    "ANALOG_COMP",
+    "TWI",          "SPM_READY",
+};
+
+Harness::Harness() : avr_(NULL), depth_(0) { ResetStats(); }
+
+Harness::~Harness() {
+  if (avr_) {
+    avr_terminate(avr_);
+  }
+}
+
+/* static */
+const char *Harness::vector_name(uint8_t vector) {
+  return vector < kNumVectors ? vector_names[vector] : "?";
+}
+
+bool Harness::Load(const char *elf_path) {
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(elf_path, &firmware) != 0) {
+    fprintf(stderr, "unable to read %s\n", elf_path);
+    return false;
+  }
+
+  avr_ = avr_make_mcu_by_name(firmware.mmcu[0] ? firmware.mmcu : "atmega328p");
+  if (!avr_) {
+    fprintf(stderr, "unsupported mcu %s\n", firmware.mmcu);
+    return false;
+  }
+  avr_init(avr_);
+  if (!firmware.frequency) {
+    firmware.frequency = 20000000;
+  }
+  avr_load_firmware(avr_, &firmware);
+  avr_->vcc = avr_->avcc = avr_->aref = 5000;
+
+  avr_register_io_write(avr_, kGpior0, &Harness::OnSectionBegin, this);
+  avr_register_io_write(avr_, kGpior1, &Harness::OnSectionEnd, this);
+  ResetStats();
+  return true;
+}
+
+void Harness::SetEeprom(const uint8_t *data, uint16_t size) {
+  avr_eeprom_desc_t eeprom;
+  eeprom.ee = const_cast<uint8_t *>(data);
+  eeprom.offset = 0;
+  eeprom.size = size;
+  avr_ioctl(avr_, AVR_IOCTL_EEPROM_SET, &eeprom);
+}
+
+void Harness::SetAdc(uint8_t channel, uint8_t reading) {
+  uint32_t millivolts = (static_cast<uint32_t>(reading) * 5000 + 127) / 255;
+  avr_raise_irq(avr_io_getirq(avr_, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + channel),
+                millivolts);
+}
+
+void Harness::SetPin(char port, uint8_t pin, bool level) {
+  avr_raise_irq(pin_irq(port, pin), level);
+}
+
+avr_irq_t *Harness::pin_irq(char port, uint8_t pin) {
+  return avr_io_getirq(avr_, AVR_IOCTL_IOPORT_GETIRQ(port), pin);
+}
+
+bool Harness::output_level(char port, uint8_t pin) const {
+  if (port == 'D' && (pin == 5 || pin == 6)) {
+    // OC0B and OC0A, COM0B1 and COM0A1 connect them to the PWM
+    uint8_t com = pin == 5 ? 0x20 : 0x80;
+    if (avr_->data[kTccr0a] & com) {
+      return avr_->data[pin == 5 ? kOcr0b : kOcr0a] != 0;
+    }
+  }
+  return avr_->data[kPortB + 3 * (port - 'B')] & (1 << pin);
+}
+
+avr_irq_t *Harness::pwm_irq(uint8_t channel) {
+  return avr_io_getirq(avr_, AVR_IOCTL_TIMER_GETIRQ('0'),
+                       TIMER_IRQ_OUT_PWM0 + channel);
+}
+
+void Harness::ResetStats() {
+  for (uint8_t i = 0; i < kNumVectors; ++i) {
+    isr_stats_[i].Reset();
+  }
+  for (uint8_t i = 0; i < BENCH_LAST; ++i) {
+    section_stats_[i].Reset();
+    section_start_[i] = 0;
+  }
+  busy_cycles_ = 0;
+  stats_start_ = avr_ ? avr_->cycle : 0;
+}
+
+bool Harness::ReadProfile(IsrProfile *isrs) const {
+  const ProfileHeader expected = {{'C', 'L', 'K', 'P'}, Profiler::kVersion,
+                                  PROFILE_LAST};
+  uint32_t size = sizeof(ProfileHeader) + PROFILE_LAST * sizeof(IsrProfile);
+  for (uint32_t address = avr_->ioend + 1; address + size <= avr_->ramend + 1u;
+       ++address) {
+    if (!memcmp(avr_->data + address, &expected, sizeof(expected))) {
+      memcpy(isrs, avr_->data + address + sizeof(ProfileHeader),
+             PROFILE_LAST * sizeof(IsrProfile));
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Harness::Run(uint64_t cycles) {
+  uint64_t end = avr_->cycle + cycles;
+  while (avr_->cycle < end) {
+    avr_flashaddr_t pc = avr_->pc;
+    uint16_t opcode = avr_->flash[pc] | (avr_->flash[pc + 1] << 8);
+
+    int state = avr_run(avr_);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      return false;
+    }
+
+    // Leaving an interrupt handler
+    if (opcode == kOpcodeReti && depth_) {
+      Frame &frame = stack_[--depth_];
+      uint64_t inclusive = avr_->cycle - frame.start;
+      uint64_t exclusive = inclusive - frame.nested;
+      isr_stats_[frame.vector].Add(exclusive);
+      busy_cycles_ += exclusive;
+      if (depth_) {
+        stack_[depth_ - 1].nested += inclusive;
+      }
+    }
+
+    // Entering one: the core has just jumped to a vector table entry
+    if (avr_->pc && avr_->pc < kNumVectors * kVectorSize &&
+        avr_->pc % kVectorSize == 0 && depth_ < kNumVectors) {
+      Frame &frame = stack_[depth_++];
+      frame.vector = avr_->pc / kVectorSize;
+      frame.start = avr_->cycle;
+      frame.nested = 0;
+    }
+  }
+  return true;
+}
+
+/* static */
+void Harness::OnSectionBegin(avr_t *avr, avr_io_addr_t addr, uint8_t value,
+                             void *param) {
+  Harness *harness = static_cast<Harness *>(param);
+  if (value < BENCH_LAST) {
+    harness->section_start_[value] = avr->cycle;
+  }
+}
+
+/* static */
+void Harness::OnSectionEnd(avr_t *avr, avr_io_addr_t addr, uint8_t value,
+                           void *param) {
+  Harness *harness = static_cast<Harness *>(param);
+  if (value < BENCH_LAST && harness->section_start_[value]) {
+    harness->section_stats_[value].Add(avr->cycle -
+                                       harness->section_start_[value]);
+    harness->section_start_[value] = 0;
+  }
+}
+
+} // namespace clkr
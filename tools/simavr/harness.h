@@ -0,0 +1,138 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// simavr harness: runs the real firmware ELF one instruction at a time,
+// drives the module's inputs and keeps per-ISR and per-section cycle
+// statistics.
+
+#pragma once
+#include <stdint.h>
+
+#include <simavr/sim_avr.h>
+
+#include "bench.h"
+#include "profiler.h"
+
+namespace clkr {
+
+const uint8_t kNumVectors = 26; // ATmega328P
+
+struct CycleStats {
+  uint32_t count;
+  uint64_t total;
+  uint32_t min;
+  uint32_t max;
+
+  void Reset() {
+    count = 0;
+    total = 0;
+    min = UINT32_MAX;
+    max = 0;
+  }
+
+  void Add(uint32_t cycles) {
+    ++count;
+    total += cycles;
+    if (cycles < min) {
+      min = cycles;
+    }
+    if (cycles > max) {
+      max = cycles;
+    }
+  }
+
+  double average() const {
+    return count ? static_cast<double>(total) / count : 0.0;
+  }
+};
+
+class Harness {
+public:
+  Harness();
+  ~Harness();
+
+  bool Load(const char *elf_path);
+
+  // Preload the EEPROM, as if the settings had been saved earlier
+  void SetEeprom(const uint8_t *data, uint16_t size);
+
+  // Set an analog input to the given 8-bit ADC reading
+  void SetAdc(uint8_t channel, uint8_t reading);
+
+  // Drive a digital input pin
+  void SetPin(char port, uint8_t pin, bool level);
+
+  // The IRQs simavr raises as an output pin changes level, and as a Timer0
+  // PWM channel's duty changes (0 is OC0A, 1 is OC0B), for VCD traces and
+  // avr_irq_register_notify()
+  avr_irq_t *pin_irq(char port, uint8_t pin);
+  avr_irq_t *pwm_irq(uint8_t channel);
+
+  // The level the firmware drives an output pin of port B, C or D to. The
+  // LED pins count as high while Timer0 drives them with a duty above 0.
+  bool output_level(char port, uint8_t pin) const;
+
+  // Run the firmware for the given number of CPU cycles.
+  // Returns false if the core stopped or crashed.
+  bool Run(uint64_t cycles);
+
+  // Forget the statistics gathered so far
+  void ResetStats();
+
+  avr_t *avr() { return avr_; }
+  uint64_t cycle() const { return avr_->cycle; }
+  uint32_t frequency() const { return avr_->frequency; }
+
+  // Statistics of each interrupt vector, excluding nested interrupts
+  const CycleStats &isr(uint8_t vector) const { return isr_stats_[vector]; }
+
+  // Statistics of each BENCH_BEGIN/BENCH_END section
+  const CycleStats &section(uint8_t id) const { return section_stats_[id]; }
+
+  // Copy out the Profiler statistics of a clkr_profile firmware, found in
+  // RAM by their header. Returns false for other builds.
+  bool ReadProfile(IsrProfile *isrs) const;
+
+  // Cycles spent in interrupt handlers since the last ResetStats()
+  uint64_t busy_cycles() const { return busy_cycles_; }
+  uint64_t elapsed_cycles() const { return avr_->cycle - stats_start_; }
+
+  static const char *vector_name(uint8_t vector);
+
+private:
+  static void OnSectionBegin(avr_t *avr, avr_io_addr_t addr, uint8_t value,
+                             void *param);
+  static void OnSectionEnd(avr_t *avr, avr_io_addr_t addr, uint8_t value,
+                           void *param);
+
+  struct Frame {
+    uint8_t vector;
+    uint64_t start;
+    uint64_t nested;
+  };
+
+  avr_t *avr_;
+  Frame stack_[kNumVectors];
+  uint8_t depth_;
+  uint64_t section_start_[BENCH_LAST];
+  CycleStats isr_stats_[kNumVectors];
+  CycleStats section_stats_[BENCH_LAST];
+  uint64_t busy_cycles_;
+  uint64_t stats_start_;
+};
+
+} // namespace clkr
@@ -0,0 +1,299 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Scripted run of the firmware in simavr.
+
+#include "script.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <simavr/sim_irq.h>
+#include <simavr/sim_vcd_file.h>
+
+#include "hal.h"
+#include "hardware_config.h"
+#include "harness.h"
+
+namespace clkr {
+
+namespace {
+
+enum Command {
+  COMMAND_ADC,
+  COMMAND_BUTTON,
+  COMMAND_PAUSE,
+  COMMAND_EEPROM,
+  COMMAND_EXPECT_EDGES,
+  COMMAND_EXPECT_PIN,
+  COMMAND_END,
+};
+
+struct Step {
+  unsigned line;
+  double time;
+  Command command;
+  uint16_t arg;  // channel, address, pin or number of edges
+  uint8_t value; // or tolerance of the number of edges
+  char port;     // of the pin
+  double since;  // start of the edges' window
+};
+
+// What the clock output has done so far
+struct ClockTrace {
+  avr_t *avr;
+  bool print_edges;
+  bool level;
+  std::vector<uint32_t> rising_per_second;
+  std::vector<uint64_t> rising; // cycle of each rising edge
+};
+
+void OnClockOut(avr_irq_t *irq, uint32_t value, void *param) {
+  ClockTrace *trace = static_cast<ClockTrace *>(param);
+  bool level = value;
+  if (level == trace->level) {
+    return;
+  }
+  trace->level = level;
+  double seconds = static_cast<double>(trace->avr->cycle) /
+                   trace->avr->frequency;
+  if (trace->print_edges) {
+    printf("%.7f,%u\n", seconds, level);
+  }
+  if (level) {
+    trace->rising.push_back(trace->avr->cycle);
+    size_t second = static_cast<size_t>(seconds);
+    if (trace->rising_per_second.size() <= second) {
+      trace->rising_per_second.resize(second + 1);
+    }
+    ++trace->rising_per_second[second];
+  }
+}
+
+// The rest of an expect line, after the time
+bool ParseExpect(const char *line, Step *step) {
+  char what[8];
+  if (sscanf(line, "%*f %*s %7s", what) != 1) {
+    return false;
+  }
+  int count, tolerance, pin, level;
+  if (!strcmp(what, "edges")) {
+    step->command = COMMAND_EXPECT_EDGES;
+    if (sscanf(line, "%*f %*s %*s %lf %d %d", &step->since, &count,
+               &tolerance) != 3 ||
+        step->since < 0.0 || step->since >= step->time || count < 0 ||
+        count > 0xffff || tolerance < 0 || tolerance > 255) {
+      return false;
+    }
+    step->arg = count;
+    step->value = tolerance;
+    return true;
+  }
+  if (!strcmp(what, "pin")) {
+    step->command = COMMAND_EXPECT_PIN;
+    if (sscanf(line, "%*f %*s %*s %c%d %d", &step->port, &pin, &level) != 3 ||
+        step->port < 'B' || step->port > 'D' || pin < 0 || pin > 7 ||
+        level < 0 || level > 1) {
+      return false;
+    }
+    step->arg = pin;
+    step->value = level;
+    return true;
+  }
+  return false;
+}
+
+bool ParseLine(const char *path, unsigned number, char *line,
+               std::vector<Step> *steps) {
+  char *comment = strchr(line, '#');
+  if (comment) {
+    *comment = '\0';
+  }
+  char name[16];
+  Step step;
+  int value = 0, extra = 0;
+  int fields = sscanf(line, "%lf %15s %d %d", &step.time, name, &value, &extra);
+  if (fields <= 0) {
+    return true; // blank
+  }
+
+  step.line = number;
+  step.arg = 0;
+  bool ok = fields >= 3;
+  if (!strcmp(name, "expect")) {
+    ok = ParseExpect(line, &step);
+    value = step.value;
+  } else if (!strcmp(name, "pot")) {
+    step.command = COMMAND_ADC;
+    step.arg = ADC_CHANNEL_TEMPO;
+  } else if (!strcmp(name, "range")) {
+    step.command = COMMAND_ADC;
+    step.arg = ADC_CHANNEL_SELECTOR;
+  } else if (!strcmp(name, "cv")) {
+    step.command = COMMAND_ADC;
+    step.arg = ADC_CHANNEL_TEMPO_CV;
+  } else if (!strcmp(name, "adc") || !strcmp(name, "eeprom")) {
+    step.command = name[0] == 'a' ? COMMAND_ADC : COMMAND_EEPROM;
+    step.arg = value;
+    value = extra;
+    ok = fields == 4 && (step.command == COMMAND_ADC || step.time == 0.0);
+  } else if (!strcmp(name, "button")) {
+    step.command = COMMAND_BUTTON;
+  } else if (!strcmp(name, "pause")) {
+    step.command = COMMAND_PAUSE;
+  } else if (!strcmp(name, "end")) {
+    step.command = COMMAND_END;
+    ok = fields == 2;
+  } else {
+    ok = false;
+  }
+  if (!steps->empty() && step.time < steps->back().time) {
+    ok = false;
+  }
+  if (!ok || value < 0 || value > 255) {
+    fprintf(stderr, "%s:%u: can't make sense of this\n", path, number);
+    return false;
+  }
+  step.value = value;
+  steps->push_back(step);
+  return true;
+}
+
+bool LoadScript(const char *path, std::vector<Step> *steps) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "unable to read %s\n", path);
+    return false;
+  }
+  char line[256];
+  unsigned number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), file)) {
+    ok = ParseLine(path, ++number, line, steps);
+  }
+  fclose(file);
+  return ok;
+}
+
+} // namespace
+
+bool RunScript(const char *elf_path, const char *script_path,
+               const char *vcd_path, bool print_edges) {
+  std::vector<Step> steps;
+  Harness harness;
+  if (!LoadScript(script_path, &steps) || !harness.Load(elf_path)) {
+    return false;
+  }
+
+  uint8_t eeprom[hal::kEepromSize];
+  memset(eeprom, 0xff, sizeof(eeprom));
+  for (const Step &step : steps) {
+    if (step.command == COMMAND_EEPROM && step.arg < sizeof(eeprom)) {
+      eeprom[step.arg] = step.value;
+    }
+  }
+  harness.SetEeprom(eeprom, sizeof(eeprom));
+  harness.SetAdc(ADC_CHANNEL_TEMPO, 128);
+  harness.SetAdc(ADC_CHANNEL_SELECTOR, 0);
+  harness.SetAdc(ADC_CHANNEL_TEMPO_CV, 255);
+  harness.SetPin('C', 3, true); // Pause CV at 0V, the input inverts
+  harness.SetPin('B', 4, false);
+
+  ClockTrace trace = {harness.avr(), print_edges, false, {}, {}};
+  avr_irq_register_notify(harness.pin_irq('B', 5), &OnClockOut, &trace);
+
+  avr_vcd_t vcd;
+  if (vcd_path) {
+    avr_vcd_init(harness.avr(), vcd_path, &vcd, 1000 /* us */);
+    avr_vcd_add_signal(&vcd, harness.pin_irq('B', 5), 1, "clock_out");
+    avr_vcd_add_signal(&vcd, harness.pin_irq('D', 5), 1, "led_top");
+    avr_vcd_add_signal(&vcd, harness.pin_irq('D', 6), 1, "led_bottom");
+    // Under hardware PWM, the LED pins only show through their duty
+    avr_vcd_add_signal(&vcd, harness.pwm_irq(1), 8, "led_top_pwm");
+    avr_vcd_add_signal(&vcd, harness.pwm_irq(0), 8, "led_bottom_pwm");
+    avr_vcd_add_signal(&vcd, harness.pin_irq('B', 4), 1, "button");
+    avr_vcd_add_signal(&vcd, harness.pin_irq('C', 3), 1, "pause_cv_n");
+    avr_vcd_start(&vcd);
+  }
+
+  bool ok = true;
+  for (const Step &step : steps) {
+    uint64_t cycle = static_cast<uint64_t>(step.time * harness.frequency());
+    if (cycle > harness.cycle() && !harness.Run(cycle - harness.cycle())) {
+      fprintf(stderr, "core stopped at %.6f s\n",
+              static_cast<double>(harness.cycle()) / harness.frequency());
+      ok = false;
+      break;
+    }
+    if (step.command == COMMAND_END) {
+      break;
+    }
+    switch (step.command) {
+    case COMMAND_ADC:
+      harness.SetAdc(step.arg, step.value);
+      break;
+    case COMMAND_BUTTON:
+      harness.SetPin('B', 4, step.value);
+      break;
+    case COMMAND_PAUSE:
+      harness.SetPin('C', 3, !step.value);
+      break;
+    case COMMAND_EXPECT_EDGES: {
+      uint64_t since =
+          static_cast<uint64_t>(step.since * harness.frequency());
+      unsigned edges = trace.rising.end() -
+                       std::lower_bound(trace.rising.begin(),
+                                        trace.rising.end(), since);
+      if (edges + step.value < step.arg || edges > step.arg + step.value) {
+        fprintf(stderr,
+                "%s:%u: %u rising edges from %.3f s, expected %u +/- %u\n",
+                script_path, step.line, edges, step.since, step.arg,
+                step.value);
+        ok = false;
+      }
+      break;
+    }
+    case COMMAND_EXPECT_PIN: {
+      bool level = harness.output_level(step.port, step.arg);
+      if (level != step.value) {
+        fprintf(stderr, "%s:%u: P%c%u is %u, expected %u\n", script_path,
+                step.line, step.port, step.arg, level, step.value);
+        ok = false;
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  if (vcd_path) {
+    avr_vcd_stop(&vcd);
+    avr_vcd_close(&vcd);
+  }
+
+  for (size_t i = 0; i < trace.rising_per_second.size(); ++i) {
+    fprintf(stderr, "%4u s: %u rising edges\n", static_cast<unsigned>(i),
+            trace.rising_per_second[i]);
+  }
+  return ok;
+}
+
+} // namespace clkr
@@ -0,0 +1,64 @@
+// Copyright 2023 Katherine Whitlock
+//
+// Author: Katherine Whitlock (kate@skylinesynths.nyc)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Scripted run of the firmware in simavr. Boots any firmware ELF (the plain
+// clkr build is fine), plays a timestamped script onto its inputs and
+// records the clock output and LEDs to a VCD file for GTKWave or similar.
+//
+//   pio run -e clkr && pio run -e simavr
+//   .pio/build/simavr/program -s run.txt -v run.vcd firmware.elf
+//
+// The script has one command per line, '#' to the end of a line is a
+// comment, and lines come in order of time:
+//
+//   <seconds> pot <0-255>              ADC1, the Clock Rate pot
+//   <seconds> range <0-255>            ADC2, 255 is the switch to the left
+//   <seconds> cv <0-255>               ADC4, the Tempo CV, 255 is 0V
+//   <seconds> adc <channel> <0-255>    any other analog input
+//   <seconds> button <0|1>             PB4, the multifunction button
+//   <seconds> pause <0|1>              the Pause CV, 1 above 2.5V
+//   <seconds> end                      stop, otherwise the last line does
+//   0 eeprom <address> <byte>          preloaded before the firmware boots
+//
+// and checks of what the firmware has done by then, each failing the run:
+//
+//   <seconds> expect edges <since> <count> <tolerance>
+//       the clock output rose count +/- tolerance times from since
+//   <seconds> expect pin <port><pin> <0|1>
+//       the level the firmware drives an output to, e.g. pin B5 for the
+//       clock output. The LEDs on D5 and D6 count as lit while their PWM
+//       duty is above 0.
+//
+// tools/simavr/scripts has a few, for the clock rate, the long press into
+// the settings menu and tap tempo.
+//
+// Before the script takes over, the pot sits in the middle, the Tempo and
+// Pause CVs at 0V, the range switch to the right and the button released.
+
+#pragma once
+
+namespace clkr {
+
+// Runs the script. Every change of the clock output goes to stdout as
+// seconds,level when print_edges is set, and the rising edges in each
+// second of the run to stderr. vcd_path may be NULL. Returns false if the
+// script or firmware can't be loaded, the core stops or an expect line
+// fails.
+bool RunScript(const char *elf_path, const char *script_path,
+               const char *vcd_path, bool print_edges);
+
+} // namespace clkr